@@ -0,0 +1,806 @@
+#include "mesh_model.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "mesh_cache.h"
+#include "obj_reader.h"
+#include "thread_pool.h"
+
+using namespace CatmullClarkSubdivision;
+
+const unsigned MeshModel::MAX_SUBDIVISION_LEVEL;
+namespace
+{
+    // part of the cache file names, levels of the other scheme never match
+    const char* const SUBDIVISION_SCHEME = "catmull_clark";
+
+    // materials name texture files relative to the model, whatever directory they were exported from
+    std::string getFileName(const std::string& path)
+    {
+        size_t separator = path.find_last_of("/\\");
+        return separator == std::string::npos ? path : path.substr(separator + 1);
+    }
+
+    bool isObjFile(const std::string& path)
+    {
+        std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : std::string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        return extension == ".obj";
+    }
+}
+
+const uint32_t MeshModel::FACES_GRAIN;
+
+void MeshModel::importModel(const char* path)
+{
+    // retrieve the directory path of the filepath
+    std::string temp(path);
+    if (temp.find_last_of('/') != std::string::npos)
+        m_modelDir = temp.substr(0, temp.find_last_of('/'));
+    else if (temp.find_last_of('\\') != std::string::npos)
+        m_modelDir = temp.substr(0, temp.find_last_of('\\'));
+
+    if (!m_cacheDirectory.empty())
+        m_isSourceHashed = hashFile(path, m_sourceHash);
+
+    // binary mesh files need no parsing, and a warm start doesn't touch assimp at all
+    if (isMeshFile(path))
+    {
+        if (!readMeshes(path, m_meshes, nullptr, std::vector<glm::uvec4*>()))
+            throw std::runtime_error(std::string("Not a valid mesh file for this scheme: ").append(path).c_str());
+    }
+    else if (!loadLevel(0, m_meshes, nullptr, std::vector<glm::uvec4*>()))
+    {
+        // OBJ, the format of every bundled model, has its own reader, assimp stays for anything else
+        if (!importObj(path))
+            importScene(path);
+
+        saveLevel(0, m_meshes);
+    }
+}
+
+void MeshModel::importScene(const char* path)
+{
+    // read file via ASSIMP
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path, aiProcess_JoinIdenticalVertices |
+                                                   aiProcess_FlipUVs);
+
+    // check for errors
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        throw std::runtime_error(std::string("ASSIMP: ").append(importer.GetErrorString()).c_str());
+
+    // process ASSIMP's root node recursively
+    std::vector<aiMesh*> sources;
+    processNode(scene->mRootNode, scene, sources);
+
+    // meshes are extracted as independent tasks, subdivision waits until a level is first asked for
+    std::vector<Mesh> meshes(sources.size());
+
+    ThreadPool::getInstance().parallelFor(static_cast<uint32_t>(sources.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            processMesh(sources[i], meshes[i]);
+    });
+
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        meshes[i].Textures = processMaterial(scene->mMaterials[sources[i]->mMaterialIndex]);
+        m_meshes.emplace_back(std::move(meshes[i]));
+    }
+}
+
+bool MeshModel::importObj(const char* path)
+{
+    std::vector<ObjMesh> sources;
+    if (!isObjFile(path) || !readObj(path, sources))
+        return false;
+
+    std::vector<Mesh> meshes(sources.size());
+
+    ThreadPool::getInstance().parallelFor(static_cast<uint32_t>(sources.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            processMesh(sources[i], meshes[i]);
+    });
+
+    for (Mesh& mesh : meshes)
+        m_meshes.emplace_back(std::move(mesh));
+
+    return true;
+}
+
+void MeshModel::exportModel(const char* path)
+{
+    for (Mesh& mesh : m_meshes)
+        restoreCpuData(mesh);
+
+    if (!writeMeshes(path, m_meshes, true))
+        throw std::runtime_error(std::string("Failed to write mesh file: ").append(path).c_str());
+}
+
+// processes a node in a recursive fashion. Collects each individual mesh located at the node and repeats this process on its children nodes (if any).
+void MeshModel::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& meshes)
+{
+    // process each mesh located at the current node
+    for (unsigned i = 0; i < node->mNumMeshes; ++i)
+    {
+        // the node object only contains indices to index the actual objects in the scene. 
+        // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+        meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+    }
+    // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+    for (unsigned i = 0; i < node->mNumChildren; ++i)
+        processNode(node->mChildren[i], scene, meshes);
+}
+
+// extracts vertices and faces only, it doesn't touch GL so meshes can be processed concurrently
+void MeshModel::processMesh(aiMesh* mesh, Mesh& newMesh)
+{
+    newMesh.Vertices.reserve(mesh->mNumVertices);
+    newMesh.Quads.reserve(mesh->mNumFaces);
+
+    // walk through each of the mesh's vertices
+    for (unsigned i = 0; i < mesh->mNumVertices; ++i)
+    {
+        Vertex vertex { };
+        vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+
+        // texture coordinates
+        if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+        {
+            // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't 
+            // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
+            vertex.TexCoord = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+        }
+        else
+            vertex.TexCoord = glm::vec2(-1.0f);
+
+        newMesh.Vertices.push_back(vertex);
+    }
+
+    // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+    for (unsigned i = 0; i < mesh->mNumFaces; ++i)
+    {
+        aiFace face = mesh->mFaces[i];
+
+        if (face.mNumIndices != 4)
+            throw std::runtime_error(std::string("Model doesn't have correct number of indices (need 4): ").append(std::to_string(face.mNumIndices)).c_str());
+
+        // retrieve all indices of the face and store them in the indices vector
+        newMesh.Quads.emplace_back(glm::uvec4(face.mIndices[0], face.mIndices[1], face.mIndices[2], face.mIndices[3]));
+    }
+}
+
+// OBJ meshes come welded already, only the faces are converted
+void MeshModel::processMesh(ObjMesh& mesh, Mesh& newMesh)
+{
+    newMesh.Vertices = std::move(mesh.Vertices);
+
+    newMesh.Quads.reserve(mesh.getFacesCount());
+
+    for (uint32_t i = 0; i < mesh.getFacesCount(); ++i)
+    {
+        const uint32_t* corners = &mesh.Corners[mesh.FaceOffsets[i]];
+        uint32_t count = mesh.FaceOffsets[i + 1] - mesh.FaceOffsets[i];
+
+        if (count != 4)
+            throw std::runtime_error(std::string("Model doesn't have correct number of indices (need 4): ").append(std::to_string(count)).c_str());
+
+        newMesh.Quads.emplace_back(glm::uvec4(corners[0], corners[1], corners[2], corners[3]));
+    }
+
+    newMesh.Textures = processMaterial(mesh.Material);
+}
+
+std::list<Texture> MeshModel::processMaterial(aiMaterial* material)
+{
+    std::list<Texture> textures;
+    // 1. diffuse maps
+    std::list<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE);
+    textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+    // 2. specular maps
+    std::list<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR);
+    textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+    // 3. normal maps
+    std::list<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT);
+    textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+    // 4. height maps
+    std::list<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT);
+    textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+
+    return textures;
+}
+
+// the types and order of the assimp materials, the OBJ importer takes bump maps for height maps too
+std::list<Texture> MeshModel::processMaterial(const ObjMaterial& material)
+{
+    const std::pair<aiTextureType, const std::string*> maps[] = { { aiTextureType_DIFFUSE,  &material.DiffuseMap },
+                                                                  { aiTextureType_SPECULAR, &material.SpecularMap },
+                                                                  { aiTextureType_HEIGHT,   &material.BumpMap },
+                                                                  { aiTextureType_AMBIENT,  &material.AmbientMap } };
+
+    std::list<Texture> textures;
+    for (const auto& map : maps)
+    {
+        if (!map.second->empty())
+            textures.push_back(Texture { 0, map.first, getFileName(*map.second) });
+    }
+
+    return textures;
+}
+
+bool MeshModel::loadLevel(unsigned level, std::list<Mesh>& meshes, const std::list<Mesh>* parents, const std::vector<glm::uvec4*>& streamedQuads)
+{
+    if (!isCacheEnabled())
+        return false;
+
+    return readMeshes(getMeshCachePath(m_cacheDirectory, m_sourceHash, getSchemeName(), level), meshes, parents, streamedQuads);
+}
+
+void MeshModel::saveLevel(unsigned level, std::list<Mesh>& meshes)
+{
+    // a failed write only costs the next start a refinement
+    if (isCacheEnabled())
+        writeMeshes(getMeshCachePath(m_cacheDirectory, m_sourceHash, getSchemeName(), level), meshes, level == 0);
+}
+
+bool MeshModel::readMeshes(const std::string& path, std::list<Mesh>& meshes, const std::list<Mesh>* parents, const std::vector<glm::uvec4*>& streamedQuads)
+{
+    // shared by the meshes, the file stays mapped until the last of them has its arrays copied out
+    std::shared_ptr<MeshCacheReader> file = std::make_shared<MeshCacheReader>();
+    const MeshCacheReader& reader = *file;
+
+    if (!file->open(path))
+        return false;
+
+    size_t index = 0;
+
+    // meshes count, corners per face and flags
+    std::vector<uint32_t> header;
+    if (!reader.read(index++, header) || header.size() != 3 || header[1] != sizeof(glm::uvec4) / sizeof(uint32_t))
+        return false;
+
+    if (parents && parents->size() != header[0])
+        return false;
+
+    const bool hasTextures = (header[2] & MESH_FILE_TEXTURES) != 0;
+    const bool hasTopology = (header[2] & MESH_FILE_TOPOLOGY) != 0;
+
+    std::list<Mesh> loaded(header[0]);
+    std::list<Mesh>::const_iterator parent = parents ? parents->begin() : std::list<Mesh>::const_iterator();
+
+    size_t i = 0;
+    for (Mesh& mesh : loaded)
+    {
+        // the arrays are used where they are, in the mapping, until restoreCpuData makes them
+        mesh.File.Reader = file;
+        mesh.File.Vertices = reader.getArray<Vertex>(index++, mesh.VerticesCount);
+
+        if (!mesh.File.Vertices)
+            return false;
+
+        if (streamedQuads.empty())
+        {
+            mesh.File.Quads = reader.getArray<glm::uvec4>(index++, mesh.QuadsCount);
+
+            if (!mesh.File.Quads)
+                return false;
+        }
+        else
+        {
+            // the buffer was sized from the parent, a file that disagrees with it isn't trusted
+            size_t count = 0;
+            const glm::uvec4* faces = reader.getArray<glm::uvec4>(index++, count);
+
+            if (!faces || count != 4 * getFacesCount(*parent))
+                return false;
+
+            std::copy(faces, faces + count, streamedQuads[i]);
+        }
+
+        if (hasTextures)
+        {
+            std::vector<uint32_t> types;
+            std::vector<char> paths;
+
+            if (!reader.read(index++, types) || !reader.read(index++, paths))
+                return false;
+
+            auto begin = paths.begin();
+            for (uint32_t type : types)
+            {
+                auto end = std::find(begin, paths.end(), '\0');
+                if (end == paths.end())
+                    return false;
+
+                Texture texture;
+                texture.Id = 0;
+                texture.Type = static_cast<aiTextureType>(type);
+                texture.Path.assign(begin, end);
+                mesh.Textures.push_back(texture);
+
+                begin = end + 1;
+            }
+        }
+
+        // a level shares the textures of the mesh it's refined from
+        if (parents)
+            mesh.Textures = parent->Textures;
+
+        // only checked here, the arrays are read with the others
+        if (hasTopology)
+        {
+            mesh.File.Topology = index;
+
+            bool isValid = true;
+            decltype(mesh.Topology)().forEachArray([&reader, &index, &isValid](auto& array)
+            {
+                size_t count = 0;
+                isValid = isValid && reader.getArray<typename std::decay_t<decltype(array)>::value_type>(index++, count);
+            });
+
+            if (!isValid)
+                return false;
+        }
+
+        if (parents)
+            ++parent;
+
+        ++i;
+    }
+
+    meshes = std::move(loaded);
+    return true;
+}
+
+bool MeshModel::writeMeshes(const std::string& path, std::list<Mesh>& meshes, bool withTextures)
+{
+    // the writer only points at the arrays, everything made here lives until the file is saved
+    std::vector<uint32_t> header { static_cast<uint32_t>(meshes.size()),
+                                   static_cast<uint32_t>(sizeof(glm::uvec4) / sizeof(uint32_t)),
+                                   MESH_FILE_TOPOLOGY | (withTextures ? MESH_FILE_TEXTURES : 0u) };
+    std::list<std::vector<uint32_t>> types;
+    std::list<std::vector<char>> paths;
+
+    MeshCacheWriter writer;
+    writer.add(header);
+
+    for (Mesh& mesh : meshes)
+    {
+        if (mesh.Topology.VertexPoints.size() != mesh.Vertices.size())
+            mesh.Topology.build(mesh.Vertices, mesh.Quads);
+
+        writer.add(mesh.Vertices);
+        writer.add(mesh.Quads);
+
+        if (withTextures)
+        {
+            types.emplace_back();
+            paths.emplace_back();
+
+            for (const Texture& texture : mesh.Textures)
+            {
+                types.back().push_back(static_cast<uint32_t>(texture.Type));
+                paths.back().insert(paths.back().end(), texture.Path.begin(), texture.Path.end());
+                paths.back().push_back('\0');
+            }
+
+            writer.add(types.back());
+            writer.add(paths.back());
+        }
+
+        mesh.Topology.forEachArray([&writer](auto& array) { writer.add(array); });
+    }
+
+    return writer.save(path);
+}
+
+void MeshModel::benchmarkSubdivision(unsigned level, SubdivisionStats& stats)
+{
+    level = std::min(level, MAX_SUBDIVISION_LEVEL);
+
+    for (Mesh& mesh : m_meshes)
+    {
+        // only the level being refined and its parent are alive
+        Mesh levels[2];
+        Mesh* parent = &mesh;
+
+        for (unsigned i = 0; i < level; ++i)
+        {
+            Mesh& refined = levels[i % 2];
+            refined = Mesh();
+
+            applySubdivision(*parent, refined, nullptr, nullptr, &stats);
+
+            stats.FacesCount += refined.Quads.size();
+            parent = &refined;
+        }
+
+        stats.VerticesCount += parent->Vertices.size();
+    }
+}
+
+const char* MeshModel::getSchemeName()
+{
+    return SUBDIVISION_SCHEME;
+}
+
+void MeshModel::addMesh(std::vector<Vertex> vertices, std::vector<Mesh::Face> faces)
+{
+    Mesh mesh;
+    mesh.Vertices = std::move(vertices);
+    mesh.Quads = std::move(faces);
+    m_meshes.emplace_back(std::move(mesh));
+}
+
+void MeshModel::updateBounds(Mesh& mesh, const Vertex* vertices)
+{
+    mesh.BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+    mesh.BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+
+    for (size_t i = 0; i < mesh.VerticesCount; ++i)
+    {
+        mesh.BoundsMin = glm::min(mesh.BoundsMin, vertices[i].Position);
+        mesh.BoundsMax = glm::max(mesh.BoundsMax, vertices[i].Position);
+    }
+}
+
+void MeshModel::restoreCpuData(Mesh& mesh)
+{
+    if (!mesh.File.Reader)
+        return;
+
+    if (mesh.Vertices.empty() && mesh.File.Vertices)
+        mesh.Vertices.assign(mesh.File.Vertices, mesh.File.Vertices + mesh.VerticesCount);
+
+    if (mesh.Quads.empty() && mesh.File.Quads)
+        mesh.Quads.assign(mesh.File.Quads, mesh.File.Quads + mesh.QuadsCount);
+
+    if (mesh.File.Topology && mesh.Topology.VertexPoints.empty())
+    {
+        // every array was checked when the file was opened
+        size_t index = mesh.File.Topology;
+        const MeshCacheReader& reader = *mesh.File.Reader;
+        mesh.Topology.forEachArray([&reader, &index](auto& array) { reader.read(index++, array); });
+    }
+
+    mesh.File = MeshFileArrays();
+}
+
+// Checks all material textures of a given type and loads the textures if they're not loaded yet.
+// the required info is returned as a Texture struct.
+std::list<Texture> MeshModel::loadMaterialTextures(aiMaterial* material, aiTextureType type)
+{
+    std::list<Texture> textures;
+    for (unsigned int i = 0; i < material->GetTextureCount(type); ++i)
+    {
+        aiString texturePath;
+        material->GetTexture(type, i, &texturePath);
+
+        std::string path = getFileName(texturePath.C_Str());
+
+        Texture texture;
+        texture.Id = 0;
+        texture.Type = type;
+        texture.Path = path;
+        textures.push_back(texture);
+    }
+    return textures;
+}
+
+void MeshModel::applySubdivision(Mesh& oldMesh, Mesh& newMesh, JobProgress* progress, glm::uvec4* streamedQuads, SubdivisionStats* stats)
+{
+    if (progress && progress->isCancelled())
+        return;
+
+    // each lap is charged to the stage that just ended
+    std::chrono::steady_clock::time_point lapStart = std::chrono::steady_clock::now();
+
+    auto lap = [&lapStart, stats](double SubdivisionStats::* stage)
+    {
+        if (!stats)
+            return;
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        stats->*stage += std::chrono::duration<double>(now - lapStart).count();
+        lapStart = now;
+    };
+
+    // a mesh mapped from its file is copied out of it first, the copy is charged to the topology
+    restoreCpuData(oldMesh);
+
+    // the topology is built once per level and kept with the mesh for refining further
+    if (oldMesh.Topology.VertexPoints.size() != oldMesh.Vertices.size())
+        oldMesh.Topology.build(oldMesh.Vertices, oldMesh.Quads);
+
+    lap(&SubdivisionStats::TopologySeconds);
+
+    const HalfEdgeTopology& topology = oldMesh.Topology;
+    const uint32_t INVALID_INDEX = HalfEdgeTopology::INVALID_INDEX;
+
+    const uint32_t facesCount = topology.getFacesCount();
+
+    auto pointVertex = [&topology](uint32_t point) { return topology.PointVertices[point]; };
+
+    // face point: centroid of the quad
+    auto pushFace = [&topology, &pointVertex](StencilTable& table, uint32_t face, float weight)
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+            table.push(pointVertex(topology.Origins[4 * face + i]), 0.25f * weight);
+    };
+
+    // edge point: average of both ends and both adjacent face points, boundary edges stay at their midpoint
+    auto pushEdge = [&topology, &pointVertex, &pushFace](StencilTable& table, uint32_t edge)
+    {
+        uint32_t h = topology.EdgeHalves[edge];
+        uint32_t twin = topology.Twins[h];
+
+        uint32_t a = pointVertex(topology.Origins[h]);
+        uint32_t b = pointVertex(topology.Origins[HalfEdgeTopology::next(h)]);
+
+        if (twin == HalfEdgeTopology::INVALID_INDEX)
+        {
+            table.push(a, 0.5f);
+            table.push(b, 0.5f);
+            return;
+        }
+
+        table.push(a, 0.25f);
+        table.push(b, 0.25f);
+        pushFace(table, HalfEdgeTopology::face(h), 0.25f);
+        pushFace(table, HalfEdgeTopology::face(twin), 0.25f);
+    };
+
+    // vertex point: (F + 2R + (n - 3)P) / n inside, (6P + left + right) / 8 along the boundary, corners are kept
+    auto pushPoint = [&topology, &pointVertex, &pushFace](StencilTable& table, uint32_t point)
+    {
+        uint32_t ringBegin = topology.RingOffsets[point];
+        uint32_t ringEnd = topology.RingOffsets[point + 1];
+        uint32_t cornerBegin = topology.CornerOffsets[point];
+        uint32_t cornerEnd = topology.CornerOffsets[point + 1];
+
+        uint32_t boundaryCount = 0;
+        for (uint32_t i = ringBegin; i < ringEnd; ++i)
+            boundaryCount += topology.isBoundary(topology.RingEdges[i]) ? 1 : 0;
+
+        if (boundaryCount == 0 && cornerBegin != cornerEnd)
+        {
+            float n = static_cast<float>(cornerEnd - cornerBegin);
+            float m = static_cast<float>(ringEnd - ringBegin);
+
+            table.push(pointVertex(point), (n - 3.0f) / n);
+
+            for (uint32_t i = cornerBegin; i < cornerEnd; ++i)
+                pushFace(table, HalfEdgeTopology::face(topology.Corners[i]), 1.0f / (n * n));
+
+            for (uint32_t i = ringBegin; i < ringEnd; ++i)
+            {
+                uint32_t h = topology.EdgeHalves[topology.RingEdges[i]];
+
+                table.push(pointVertex(topology.Origins[h]), 1.0f / (m * n));
+                table.push(pointVertex(topology.Origins[HalfEdgeTopology::next(h)]), 1.0f / (m * n));
+            }
+        }
+        else if (boundaryCount == 2)
+        {
+            table.push(pointVertex(point), 0.75f);
+
+            for (uint32_t i = ringBegin; i < ringEnd; ++i)
+            {
+                uint32_t edge = topology.RingEdges[i];
+                if (!topology.isBoundary(edge))
+                    continue;
+
+                uint32_t h = topology.EdgeHalves[edge];
+                uint32_t other = topology.Origins[h] == point ? topology.Origins[HalfEdgeTopology::next(h)] : topology.Origins[h];
+
+                table.push(pointVertex(other), 0.125f);
+            }
+        }
+        else
+            table.push(pointVertex(point), 1.0f);
+    };
+
+    // every quad is split into four, texture coordinates are interpolated inside the parent face.
+    // child vertices are keyed by what they were made from: one per parent vertex, one per parent face and
+    // one per edge, unless the faces on both sides disagree on its texture coordinate (a seam).
+    // A child vertex belongs to the first half-edge that makes it, so chunks of faces are refined in parallel and
+    // numbered by a prefix sum of their own vertices, giving the same result for any number of threads
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    const uint32_t halfEdgesCount = topology.getHalfEdgesCount();
+    const uint32_t chunksCount = (facesCount + FACES_GRAIN - 1) / FACES_GRAIN;
+
+    std::vector<std::atomic<uint32_t>> cornerOwners(oldMesh.Vertices.size());
+
+    pool.parallelFor(static_cast<uint32_t>(cornerOwners.size()), 4 * FACES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t v = begin; v < end; ++v)
+            cornerOwners[v].store(INVALID_INDEX, std::memory_order_relaxed);
+    });
+
+    pool.parallelFor(halfEdgesCount, 4 * FACES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t h = begin; h < end; ++h)
+            atomicMin(cornerOwners[oldMesh.Quads[HalfEdgeTopology::face(h)][h & 3]], h);
+    });
+
+    lap(&SubdivisionStats::DedupeSeconds);
+
+    auto halfEdgeTexCoord = [&oldMesh](uint32_t h)
+    {
+        const glm::uvec4& quad = oldMesh.Quads[HalfEdgeTopology::face(h)];
+        return 0.5f * (oldMesh.Vertices[quad[h & 3]].TexCoord + oldMesh.Vertices[quad[(h + 1) & 3]].TexCoord);
+    };
+
+    // per face: bits 0-3 mark the corners it makes a vertex for, bits 4-7 the edges
+    std::vector<uint8_t> ownedMasks(facesCount);
+    std::vector<uint32_t> chunkBases(chunksCount + 1, 0);
+    std::vector<StencilTable> positionParts(chunksCount);
+    std::vector<StencilTable> texCoordParts(chunksCount);
+
+    pool.parallelFor(facesCount, FACES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        // cancelled chunks are skipped, the caller drops the whole result
+        if (progress && progress->isCancelled())
+            return;
+
+        uint32_t chunk = begin / FACES_GRAIN;
+        uint32_t ownedCount = 0;
+
+        // positions are weighted over one vertex per welded point, texture coordinates over the face corners
+        StencilTable& stencils = positionParts[chunk];
+        StencilTable& texCoordStencils = texCoordParts[chunk];
+
+        stencils.reserve(3 * (end - begin), 24 * static_cast<size_t>(end - begin));
+        texCoordStencils.reserve(3 * (end - begin), 6 * static_cast<size_t>(end - begin));
+
+        for (uint32_t f = begin; f < end; ++f)
+        {
+            const glm::uvec4& quad = oldMesh.Quads[f];
+            uint8_t mask = 0;
+
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                uint32_t h = 4 * f + i;
+
+                if (cornerOwners[quad[i]].load(std::memory_order_relaxed) == h)
+                {
+                    mask |= 1 << i;
+                    ++ownedCount;
+
+                    pushPoint(stencils, topology.VertexPoints[quad[i]]);
+                    stencils.close();
+
+                    texCoordStencils.push(quad[i], 1.0f);
+                    texCoordStencils.close();
+                }
+
+                uint32_t first = topology.EdgeHalves[topology.Edges[h]];
+
+                if (first == h || halfEdgeTexCoord(first) != halfEdgeTexCoord(h))
+                {
+                    mask |= 0x10 << i;
+                    ++ownedCount;
+
+                    pushEdge(stencils, topology.Edges[h]);
+                    stencils.close();
+
+                    texCoordStencils.push(quad[i], 0.5f);
+                    texCoordStencils.push(quad[(i + 1) & 3], 0.5f);
+                    texCoordStencils.close();
+                }
+            }
+
+            ++ownedCount;
+
+            pushFace(stencils, f, 1.0f);
+            stencils.close();
+
+            for (uint32_t i = 0; i < 4; ++i)
+                texCoordStencils.push(quad[i], 0.25f);
+            texCoordStencils.close();
+
+            ownedMasks[f] = mask;
+        }
+
+        chunkBases[chunk + 1] = ownedCount;
+
+        if (progress)
+            progress->advance(end - begin);
+    });
+
+    if (progress && progress->isCancelled())
+        return;
+
+    lap(&SubdivisionStats::RefineSeconds);
+
+    for (uint32_t c = 0; c < chunksCount; ++c)
+        chunkBases[c + 1] += chunkBases[c];
+
+    std::vector<uint32_t> cornerSlots(oldMesh.Vertices.size(), INVALID_INDEX);
+    std::vector<uint32_t> halfEdgeSlots(halfEdgesCount, INVALID_INDEX);
+    std::vector<uint32_t> faceSlots(facesCount);
+
+    pool.parallelFor(facesCount, FACES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        uint32_t slot = chunkBases[begin / FACES_GRAIN];
+
+        for (uint32_t f = begin; f < end; ++f)
+        {
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                if (ownedMasks[f] & (1 << i))
+                    cornerSlots[oldMesh.Quads[f][i]] = slot++;
+
+                if (ownedMasks[f] & (0x10 << i))
+                    halfEdgeSlots[4 * f + i] = slot++;
+            }
+
+            faceSlots[f] = slot++;
+        }
+    });
+
+    lap(&SubdivisionStats::DedupeSeconds);
+
+    glm::uvec4* quads = streamedQuads;
+
+    if (!quads)
+    {
+        newMesh.Quads.resize(4 * static_cast<size_t>(facesCount));
+        quads = newMesh.Quads.data();
+    }
+
+    pool.parallelFor(facesCount, FACES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t f = begin; f < end; ++f)
+        {
+            const glm::uvec4& quad = oldMesh.Quads[f];
+
+            uint32_t corners[4];
+            uint32_t edges[4];
+
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                uint32_t h = 4 * f + i;
+
+                corners[i] = cornerSlots[quad[i]];
+                edges[i] = ownedMasks[f] & (0x10 << i) ? halfEdgeSlots[h] : halfEdgeSlots[topology.EdgeHalves[topology.Edges[h]]];
+            }
+
+            quads[4 * f + 0] = glm::uvec4(edges[3], corners[0], edges[0], faceSlots[f]);
+            quads[4 * f + 1] = glm::uvec4(edges[0], corners[1], edges[1], faceSlots[f]);
+            quads[4 * f + 2] = glm::uvec4(edges[1], corners[2], edges[2], faceSlots[f]);
+            quads[4 * f + 3] = glm::uvec4(edges[2], corners[3], edges[3], faceSlots[f]);
+        }
+    });
+
+    newMesh.Stencils = concatenateStencils(positionParts);
+    StencilTable texCoordStencils = concatenateStencils(texCoordParts);
+
+    lap(&SubdivisionStats::RefineSeconds);
+
+    // a streamed level is evaluated by a second job, right into its vertex buffer once collectSubdivision mapped it
+    if (streamedQuads)
+    {
+        newMesh.TexCoordStencils = std::move(texCoordStencils);
+        return;
+    }
+
+    newMesh.Vertices.resize(newMesh.Stencils.getStencilsCount());
+    evaluateVertices(newMesh.Stencils, texCoordStencils, oldMesh.Vertices, newMesh.Vertices.data(), newMesh.BoundsMin, newMesh.BoundsMax);
+
+    lap(&SubdivisionStats::EvaluateSeconds);
+}
@@ -1,16 +1,11 @@
 #include "model.h"
 
 #include <algorithm>
+#include <chrono>
 #include <exception>
 #include <fstream>
 #include <iostream>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
+#include <limits>
 
 #undef APIENTRY
 #include <glad/glad.h>
@@ -18,68 +13,137 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "shader_cache.h"
+#include "texture_cache.h"
+#include "thread_pool.h"
+#include "topology.h"
 #include "utils.h"
 
 using namespace CatmullClarkSubdivision;
 
 Model::~Model()
 {
+    // the job refers to the meshes below
+    if (m_subdivisionJob.valid())
+    {
+        m_subdivisionProgress.cancel();
+        m_subdivisionJob.wait();
+
+        // the vertex buffers mapped for the last level are only held by the job's result
+        if (m_isStreamEvaluating)
+        {
+            try
+            {
+                std::vector<std::list<Mesh>> levels = m_subdivisionJob.get();
+
+                for (Mesh& mesh : levels.back())
+                    deleteBuffers(mesh);
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    // deleting a mapped buffer unmaps it
+    for (unsigned buffer : m_streamedBuffers)
+        glDeleteBuffers(1, &buffer);
+
     for (Mesh& mesh : m_meshes)
+        deleteBuffers(mesh);
+
+    // textures are shared by every mesh and level using them, and with other models through the cache
+    for (auto& texture : m_textures)
     {
-        glDeleteVertexArrays(1, &mesh.VAO);
-        glDeleteBuffers(1, &mesh.VBO);
-        glDeleteBuffers(1, &mesh.EBO);
-        
-        for (Texture tex : mesh.Textures)
-            glDeleteTextures(1, &tex.Id);
+        if (!texture.second.empty())
+            TextureCache::getInstance().release(texture.second);
     }
 
-    for (Mesh& mesh : m_subdividedMeshes)
+    for (std::list<Mesh>& level : m_subdividedMeshes)
     {
-        glDeleteVertexArrays(1, &mesh.VAO);
-        glDeleteBuffers(1, &mesh.VBO);
-        glDeleteBuffers(1, &mesh.EBO);
+        for (Mesh& mesh : level)
+            deleteBuffers(mesh);
+    }
+}
 
-        for (Texture tex : mesh.Textures)
-            glDeleteTextures(1, &tex.Id);
+void Model::loadModel(const char* path)
+{
+    importModel(path);
+    decodeTextures();
+    uploadModel();
+}
+
+void Model::decodeTextures()
+{
+    // one reference per texture file, every file is read and decoded once all of them are known
+    for (const Mesh& mesh : m_meshes)
+    {
+        for (const Texture& texture : mesh.Textures)
+            m_textures.emplace(texture.Path, std::string());
+    }
+
+    std::vector<std::map<std::string, std::string>::iterator> files;
+    for (auto texture = m_textures.begin(); texture != m_textures.end(); ++texture)
+    {
+        if (texture->second.empty())
+            files.push_back(texture);
     }
 
-    m_shader.release();
+    ThreadPool::getInstance().parallelFor(static_cast<uint32_t>(files.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            files[i]->second = TextureCache::getInstance().acquire(m_modelDir + std::string("\\").append(files[i]->first));
+    });
 }
 
-void Model::loadModel(const char* path, glm::mat4 projection, glm::mat4 view)
+void Model::exportModel(const char* path)
 {
-    // retrieve the directory path of the filepath
-    std::string temp(path);
-    if (temp.find_last_of('/') != std::string::npos)
-        m_modelDir = temp.substr(0, temp.find_last_of('/'));
-    else if (temp.find_last_of('\\') != std::string::npos)
-        m_modelDir = temp.substr(0, temp.find_last_of('\\'));
-
-    // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
-    stbi_set_flip_vertically_on_load(false);
-
-    // read file via ASSIMP
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_JoinIdenticalVertices |
-                                                   aiProcess_FlipUVs);
-
-    // check for errors
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
-        throw std::exception(std::string("ASSIMP: ").append(importer.GetErrorString()).c_str());
-
-    // process ASSIMP's root node recursively
-    processNode(scene->mRootNode, scene);
-
-    m_shader.loadShader(getFileFullPath("shaders\\vertex.vs").c_str(),
-                        getFileFullPath("shaders\\fragment.fs").c_str());
-
-    m_shader.use();
-    m_shader.setMat4("view", view);
-    m_shader.setMat4("projection", projection);
+    for (Mesh& mesh : m_meshes)
+        restoreCpuData(mesh);
+
+    bool isWritten = writeMeshes(path, m_meshes, true);
+
+    if (m_isGpuResident)
+        releaseCpuData();
+
+    if (!isWritten)
+        throw std::exception(std::string("Failed to write mesh file: ").append(path).c_str());
 }
 
-void Model::draw(EModelViewType viewType)
+void Model::uploadModel()
+{
+    // the shader comes first, draw records resolve their samplers against it
+    m_shader = ShaderCache::getInstance().getShader(getFileFullPath("shaders\\vertex.vs").c_str(),
+                                                    getFileFullPath("shaders\\fragment.fs").c_str());
+
+    // view and projection come from the camera buffer the engine binds every frame
+    m_modelUniform = m_shader->getUniform<glm::mat4>("model");
+
+    auto upload = [this](std::list<Mesh>& meshes, std::vector<DrawRecord>& records)
+    {
+        for (Mesh& mesh : meshes)
+        {
+            for (Texture& texture : mesh.Textures)
+                texture.Id = TextureCache::getInstance().getTexture(m_textures[texture.Path]);
+
+            setupMesh(mesh);
+            records.emplace_back(bakeDrawRecord(mesh));
+        }
+    };
+
+    upload(m_meshes, m_drawRecords);
+
+    for (std::list<Mesh>& level : m_subdividedMeshes)
+    {
+        m_subdividedDrawRecords.emplace_back();
+        upload(level, m_subdividedDrawRecords.back());
+    }
+
+    if (m_isGpuResident)
+        releaseCpuData();
+}
+
+void Model::draw(EModelViewType viewType, unsigned level)
 {
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, m_position);
@@ -88,65 +152,28 @@ void Model::draw(EModelViewType viewType)
     model = glm::rotate(model, glm::radians(m_rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
     model = glm::scale(model, glm::vec3(1.0f) * m_scale);
 
-    m_shader.use();
+    m_shader->use();
 
-    m_shader.setMat4("model", model);
+    m_shader->set(m_modelUniform, model);
 
-    std::list<Mesh> meshes = m_meshes;
+    // the original stays on screen while the level is being refined
+    bool isReady = level > 0 && level <= m_subdividedDrawRecords.size();
 
-    if (viewType == EModelViewType::ESubdiveded)
-        meshes = m_subdividedMeshes;
+    const std::vector<DrawRecord>& records = viewType == EModelViewType::ESubdiveded && isReady ? m_subdividedDrawRecords[level - 1] : m_drawRecords;
 
     // draw meshes
-    for (Mesh& mesh : meshes)
+    for (const DrawRecord& record : records)
     {
-        // bind appropriate textures
-        unsigned diffuseNr = 1;
-        unsigned specularNr = 1;
-        unsigned normalNr = 1;
-        unsigned heightNr = 1;
-
-        auto it = mesh.Textures.cbegin();
-
-        for (unsigned i = 0; i < mesh.Textures.size(); ++i, ++it)
+        // samplers were pointed at their units once at load, only the binds are left
+        for (const TextureBinding& texture : record.Textures)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-
-            if (it->Type == aiTextureType_DIFFUSE)
-            {
-                const char* tmp = std::string("diffuse_").append(std::to_string(diffuseNr)).c_str();
-                m_shader.setInt(tmp, i);
-                ++diffuseNr;
-            }
-            else if (it->Type == aiTextureType_SPECULAR)
-            {
-                const char* tmp = std::string("specular_").append(std::to_string(specularNr)).c_str();
-                m_shader.setInt(tmp, i);
-                ++specularNr;
-            }
-            else if (it->Type == aiTextureType_HEIGHT)
-            {
-                const char* tmp = std::string("normal_").append(std::to_string(normalNr)).c_str();
-                m_shader.setInt(tmp, i);
-                ++normalNr;
-            }
-            else if (it->Type == aiTextureType_AMBIENT)
-            {
-                const char* tmp = std::string("height_").append(std::to_string(heightNr)).c_str();
-                m_shader.setInt(tmp, i);
-                ++heightNr;
-            }
-
-            // now set the sampler to the correct texture unit
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, it->Id);
+            glActiveTexture(GL_TEXTURE0 + texture.Unit);
+            glBindTexture(GL_TEXTURE_2D, texture.Id);
         }
 
-        // draw mesh
-        glBindVertexArray(mesh.VAO);
+        glBindVertexArray(record.VAO);
 
-        glDrawElements(GL_QUADS, 4 * static_cast<unsigned>(mesh.Quads.size()), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_QUADS, record.IndicesCount, GL_UNSIGNED_INT, 0);
 
         glBindVertexArray(0);
 
@@ -155,416 +182,584 @@ void Model::draw(EModelViewType viewType)
     }
 }
 
-// processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-void Model::processNode(aiNode* node, const aiScene* scene)
+bool Model::subdivide(unsigned level)
 {
-    // process each mesh located at the current node
-    for (unsigned i = 0; i < node->mNumMeshes; ++i)
+    level = std::min(level, MAX_SUBDIVISION_LEVEL);
+
+    collectSubdivision(false);
+
+    // every level is refined from the previous cached one and kept, so switching levels never recomputes
+    if (!m_subdivisionJob.valid() && m_subdividedMeshes.size() < level)
     {
-        // the node object only contains indices to index the actual objects in the scene. 
-        // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        processMesh(mesh, scene);
+        std::list<Mesh>* source = m_subdividedMeshes.empty() ? &m_meshes : &m_subdividedMeshes.back();
+
+        // the job refines from the arrays, they are released again when it's collected
+        for (Mesh& mesh : *source)
+            restoreCpuData(mesh);
+
+        unsigned firstLevel = static_cast<unsigned>(m_subdividedMeshes.size()) + 1;
+        unsigned levelsCount = level - static_cast<unsigned>(m_subdividedMeshes.size());
+
+        // progress is counted in parent faces, each level has four times the faces of the previous one
+        uint64_t facesCount = 0;
+        for (const Mesh& mesh : *source)
+            facesCount += mesh.Quads.size();
+
+        uint64_t total = 0;
+        for (unsigned i = 0; i < levelsCount; ++i, facesCount *= 4)
+            total += facesCount;
+
+        m_subdivisionProgress.start(total);
+
+        // a GPU-resident model has no use for the last level's arrays, its quads go straight into mapped index buffers.
+        // Their count is known up front, every face is split in four
+        std::vector<glm::uvec4*> streamedQuads;
+
+        if (m_isGpuResident)
+        {
+            for (const Mesh& mesh : *source)
+            {
+                GLsizeiptr size = static_cast<GLsizeiptr>(std::max<size_t>((mesh.Quads.size() << (2 * levelsCount)) * sizeof(glm::uvec4), 1));
+                GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT;
+
+                unsigned buffer = 0;
+                glCreateBuffers(1, &buffer);
+                glNamedBufferStorage(buffer, size, nullptr, flags);
+
+                m_streamedBuffers.push_back(buffer);
+                streamedQuads.push_back(static_cast<glm::uvec4*>(glMapNamedBufferRange(buffer, 0, size, flags)));
+            }
+        }
+
+        // the job only reads the cached levels (and fills their topology), nothing it writes is drawn until collected
+        m_subdivisionJob = ThreadPool::getInstance().submit([this, source, firstLevel, levelsCount, streamedQuads]()
+        {
+            std::vector<std::list<Mesh>> levels;
+            levels.reserve(levelsCount);
+
+            for (unsigned i = 0; i < levelsCount && !m_subdivisionProgress.isCancelled(); ++i)
+            {
+                bool isLast = i + 1 == levelsCount;
+                levels.emplace_back(refineLevel(firstLevel + i, i == 0 ? *source : levels.back(), isLast ? streamedQuads : std::vector<glm::uvec4*>()));
+            }
+
+            return levels;
+        });
     }
-    // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
-    for (unsigned i = 0; i < node->mNumChildren; ++i)
-        processNode(node->mChildren[i], scene);
+
+    return m_subdividedMeshes.size() >= level;
 }
 
-void Model::processMesh(aiMesh* mesh, const aiScene* scene)
+void Model::waitSubdivision()
 {
-    Mesh newMesh { };
+    collectSubdivision(true);
+}
+
+void Model::cancelSubdivision()
+{
+    if (m_subdivisionJob.valid())
+        m_subdivisionProgress.cancel();
+}
+
+void Model::collectSubdivision(bool wait)
+{
+    if (!m_subdivisionJob.valid())
+        return;
+
+    if (!wait && m_subdivisionJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    std::vector<std::list<Mesh>> levels = m_subdivisionJob.get();
 
-    // walk through each of the mesh's vertices
-    for (unsigned i = 0; i < mesh->mNumVertices; ++i)
+    // The streamed level comes back with its stencils only, its vertex count isn't known before it's refined.
+    // Its vertex buffers are mapped here and the levels go back to the pool to be evaluated into them, the frame
+    // collecting the job is left with unmapping and making the vertex arrays
+    if (!m_streamedBuffers.empty() && !m_isStreamEvaluating && !m_subdivisionProgress.isCancelled())
     {
-        Vertex vertex { };
-        vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        const std::list<Mesh>* sourceParents = m_subdividedMeshes.empty() ? &m_meshes : &m_subdividedMeshes.back();
+        std::vector<Vertex*> vertices = mapStreamedVertices(levels.back());
 
-        // texture coordinates
-        if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+        m_isStreamEvaluating = true;
+        m_subdivisionJob = ThreadPool::getInstance().submit([levels = std::move(levels), sourceParents, vertices]() mutable
         {
-            // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't 
-            // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-            vertex.TexCoord = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
-        }
-        else
-            vertex.TexCoord = glm::vec2(-1.0f);
+            evaluateStreamedLevel(levels.back(), levels.size() > 1 ? levels[levels.size() - 2] : *sourceParents, vertices);
+            return std::move(levels);
+        });
 
-        newMesh.Vertices.push_back(vertex);
+        collectSubdivision(wait);
+        return;
     }
 
-    // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
-    for (unsigned i = 0; i < mesh->mNumFaces; ++i)
+    bool isStreamEvaluated = m_isStreamEvaluating;
+    m_isStreamEvaluating = false;
+
+    // a cancelled job stops at any point, none of its levels is trusted
+    if (!m_subdivisionProgress.isCancelled())
     {
-        aiFace face = mesh->mFaces[i];
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            std::list<Mesh>& level = levels[i];
+            const std::list<Mesh>& parents = m_subdividedMeshes.empty() ? m_meshes : m_subdividedMeshes.back();
+            bool isStreamed = !m_streamedBuffers.empty() && i + 1 == levels.size();
+
+            std::vector<DrawRecord> records;
+            records.reserve(level.size());
+
+            auto parent = parents.begin();
+            auto buffer = m_streamedBuffers.begin();
+
+            for (Mesh& mesh : level)
+            {
+                if (isStreamed)
+                    setupStreamedMesh(mesh, *parent, *buffer++);
+                else
+                    setupMesh(mesh);
 
-        if (face.mNumIndices != 4)
-            throw std::exception(std::string("Model doesn't have correct number of indices (need 4): ").append(std::to_string(face.mNumIndices)).c_str());
+                records.emplace_back(bakeDrawRecord(mesh));
+                ++parent;
+            }
 
-        // retrieve all indices of the face and store them in the indices vector
-        newMesh.Quads.emplace_back(glm::uvec4(face.mIndices[0], face.mIndices[1], face.mIndices[2], face.mIndices[3]));
+            m_subdividedMeshes.emplace_back(std::move(level));
+            m_subdividedDrawRecords.emplace_back(std::move(records));
+        }
     }
+    else
+    {
+        if (isStreamEvaluated)
+        {
+            for (Mesh& mesh : levels.back())
+                deleteBuffers(mesh);
+        }
 
-    // process materials
-    aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-
-    std::list<Texture> textures;
-    // 1. diffuse maps
-    std::list<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE);
-    textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-    // 2. specular maps
-    std::list<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR);
-    textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-    // 3. normal maps
-    std::list<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT);
-    textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-    // 4. height maps
-    std::list<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT);
-    textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-
-    newMesh.Textures = textures;
+        for (unsigned buffer : m_streamedBuffers)
+            glDeleteBuffers(1, &buffer);
+    }
 
-    // create buffers/arrays
-    glGenVertexArrays(1, &newMesh.VAO);
-    glGenBuffers(1, &newMesh.VBO);
-    glGenBuffers(1, &newMesh.EBO);
+    m_streamedBuffers.clear();
 
-    glBindVertexArray(newMesh.VAO);
-    // load data into vertex buffers
-    glBindBuffer(GL_ARRAY_BUFFER, newMesh.VBO);
+    if (m_isGpuResident)
+        releaseCpuData();
+}
 
-    // A great thing about structs is that their memory layout is sequential for all its items.
-    // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-    // again translates to 3/2 floats which translates to a byte array.
-    glBufferData(GL_ARRAY_BUFFER, newMesh.Vertices.size() * sizeof(Vertex), newMesh.Vertices.data(), GL_STATIC_DRAW);
+std::list<Mesh> Model::refineLevel(unsigned level, std::list<Mesh>& source, const std::vector<glm::uvec4*>& streamedQuads)
+{
+    std::list<Mesh> refined;
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, newMesh.EBO);
+    // a cached level costs a copy out of the mapped file, progress moves as if it had been refined
+    if (loadLevel(level, refined, &source, streamedQuads))
+    {
+        for (const Mesh& mesh : source)
+            m_subdivisionProgress.advance(getFacesCount(mesh));
 
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, newMesh.Quads.size() * sizeof(glm::uvec4), newMesh.Quads.data(), GL_STATIC_DRAW);
+        return refined;
+    }
 
-    // set the vertex attribute pointers
-    // vertex Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    // the cache is written from the arrays, so a streamed level is refined into them and copied to its buffers after
+    bool isCached = isCacheEnabled();
 
-    // vertex texture coords
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoord));
+    refined.resize(source.size());
 
-    glBindVertexArray(0);
+    // meshes are refined concurrently
+    std::vector<std::pair<Mesh*, Mesh*>> pairs;
+    pairs.reserve(source.size());
 
-    Mesh subdivMesh { };
-    applySubdivision(newMesh, subdivMesh);
+    auto target = refined.begin();
+    for (Mesh& mesh : source)
+        pairs.emplace_back(&mesh, &*target++);
 
-    // create buffers/arrays
-    glGenVertexArrays(1, &subdivMesh.VAO);
-    glGenBuffers(1, &subdivMesh.VBO);
-    glGenBuffers(1, &subdivMesh.EBO);
+    ThreadPool::getInstance().parallelFor(static_cast<uint32_t>(pairs.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            pairs[i].second->Textures = pairs[i].first->Textures;
+            applySubdivision(*pairs[i].first, *pairs[i].second, &m_subdivisionProgress, isCached || streamedQuads.empty() ? nullptr : streamedQuads[i]);
+        }
+    });
 
-    glBindVertexArray(subdivMesh.VAO);
-    // load data into vertex buffers
-    glBindBuffer(GL_ARRAY_BUFFER, subdivMesh.VBO);
+    // a cancelled job leaves incomplete meshes behind, they never make it to the cache
+    if (isCached && !m_subdivisionProgress.isCancelled())
+    {
+        saveLevel(level, refined);
 
-    // A great thing about structs is that their memory layout is sequential for all its items.
-    // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-    // again translates to 3/2 floats which translates to a byte array.
-    glBufferData(GL_ARRAY_BUFFER, subdivMesh.Vertices.size() * sizeof(Vertex), subdivMesh.Vertices.data(), GL_STATIC_DRAW);
+        if (!streamedQuads.empty())
+        {
+            size_t i = 0;
+            for (Mesh& mesh : refined)
+            {
+                std::copy(mesh.Quads.begin(), mesh.Quads.end(), streamedQuads[i++]);
+                std::vector<glm::uvec4>().swap(mesh.Quads);
+            }
+        }
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, subdivMesh.EBO);
+    return refined;
+}
 
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, subdivMesh.Quads.size() * sizeof(glm::uvec4), subdivMesh.Quads.data(), GL_STATIC_DRAW);
+void Model::deformCage(size_t meshIndex, const std::vector<glm::vec3>& positions)
+{
+    if (meshIndex >= m_meshes.size())
+        throw std::exception("Mesh index is out of range");
 
-    // set the vertex attribute pointers
-    // vertex Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    Mesh& cage = *std::next(m_meshes.begin(), meshIndex);
 
-    // vertex texture coords
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoord));
+    if (positions.size() != cage.VerticesCount)
+        throw std::exception("Deformed positions don't match the number of original vertices");
 
-    glBindVertexArray(0);
+    // levels still being refined would miss the new positions
+    collectSubdivision(true);
 
-    m_subdividedMeshes.emplace_back(subdivMesh);
+    // released arrays are read back and released stencils rebuilt by refining the parent again, which only
+    // depends on its topology. It happens before anything moves, so the welding stays the one the level was made with
+    restoreCpuData(cage);
 
-    m_meshes.emplace_back(newMesh);
-}
+    Mesh* parent = &cage;
 
-// Checks all material textures of a given type and loads the textures if they're not loaded yet.
-// the required info is returned as a Texture struct.
-std::list<Texture> Model::loadMaterialTextures(aiMaterial* material, aiTextureType type)
-{
-    std::list<Texture> textures;
-    for (unsigned int i = 0; i < material->GetTextureCount(type); ++i)
+    for (std::list<Mesh>& level : m_subdividedMeshes)
     {
-        aiString texturePath;
-        material->GetTexture(type, i, &texturePath);
-
-        std::string path = texturePath.C_Str();
-        if (path.find_last_of('/') != std::string::npos)
-            path = path.substr(path.find_last_of('/') + 1);
-        else if (path.find_last_of('\\') != std::string::npos)
-            path = path.substr(path.find_last_of('\\') + 1);
-
-        // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-        if (m_loadedTextures.find(texturePath.C_Str()) == m_loadedTextures.end())
-        {   // if texture hasn't been loaded already, load it
-            Texture texture;
-            texture.Id = textureFromFile(path.c_str());
-            texture.Type = type;
-            texture.Path = path.c_str();
-            textures.push_back(texture);
-            m_loadedTextures.insert(texturePath.C_Str()); // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
+        Mesh& mesh = *std::next(level.begin(), meshIndex);
+        restoreCpuData(mesh);
+
+        if (mesh.Stencils.getStencilsCount() != mesh.Vertices.size())
+        {
+            Mesh refined;
+            applySubdivision(*parent, refined);
+            mesh.Stencils = std::move(refined.Stencils);
         }
+
+        parent = &mesh;
     }
-    return textures;
-}
 
-unsigned Model::textureFromFile(const char* path)
-{
-    std::string filename = m_modelDir + std::string("\\").append(path);
+    for (size_t i = 0; i < positions.size(); ++i)
+        cage.Vertices[i].Position = positions[i];
 
-    unsigned textureID;
-    glGenTextures(1, &textureID);
+    glBindBuffer(GL_ARRAY_BUFFER, cage.VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, cage.Vertices.size() * sizeof(Vertex), cage.Vertices.data());
+    updateBounds(cage, cage.Vertices.data());
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+    // topology is untouched, so every level is a single sparse product with the original positions
+    const StencilTable* parentStencils = nullptr;
 
-    if (data)
+    for (std::list<Mesh>& level : m_subdividedMeshes)
     {
-        GLenum format = GL_RGB;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+        Mesh& mesh = *std::next(level.begin(), meshIndex);
+
+        if (mesh.CageStencils.getStencilsCount() != mesh.Vertices.size())
+            mesh.CageStencils = parentStencils ? composeStencils(mesh.Stencils, *parentStencils) : mesh.Stencils;
+
+        evaluatePositions(mesh.CageStencils, cage.Vertices, mesh.Vertices);
+        updateBounds(mesh, mesh.Vertices.data());
+
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, mesh.Vertices.size() * sizeof(Vertex), mesh.Vertices.data());
+
+        parentStencils = &mesh.CageStencils;
     }
-    else
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (m_isGpuResident)
+        releaseCpuData();
+}
+
+void Model::setGpuResident(bool isResident)
+{
+    // the running job reads the arrays of the level it refines from
+    waitSubdivision();
+
+    m_isGpuResident = isResident;
+
+    if (m_isGpuResident)
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        releaseCpuData();
+        return;
     }
 
-    return textureID;
+    for (Mesh& mesh : m_meshes)
+        restoreCpuData(mesh);
+
+    for (std::list<Mesh>& level : m_subdividedMeshes)
+    {
+        for (Mesh& mesh : level)
+            restoreCpuData(mesh);
+    }
 }
 
-void Model::applySubdivision(Mesh& oldMesh, Mesh& newMesh)
+void Model::setupMesh(Mesh& mesh)
 {
-    std::map<std::string, glm::vec3> adjustedEdges;
-    std::map<std::string, std::set<std::string>> vertexAndEdges;
-    std::map<std::string, std::set<int32_t>> vertexAndFaces;
+    // a mesh read from a mesh file is uploaded right from the mapping, its counts were taken from the file
+    if (!mesh.File.Reader)
+    {
+        mesh.VerticesCount = mesh.Vertices.size();
+        mesh.QuadsCount    = mesh.Quads.size();
+    }
 
-    std::map<std::string, glm::vec3> stringToVec3;
+    const Vertex* vertices = mesh.Vertices.empty() ? mesh.File.Vertices : mesh.Vertices.data();
+    const glm::uvec4* quads = mesh.Quads.empty() ? mesh.File.Quads : mesh.Quads.data();
 
-    for (const glm::uvec4& quad : oldMesh.Quads)
-    {
-        size_t a = newMesh.Vertices.size();
-        newMesh.Vertices.emplace_back(oldMesh.Vertices[quad.x]);
-        size_t b = newMesh.Vertices.size();
-        newMesh.Vertices.emplace_back(oldMesh.Vertices[quad.y]);
-        size_t c = newMesh.Vertices.size();
-        newMesh.Vertices.emplace_back(oldMesh.Vertices[quad.z]);
-        size_t d = newMesh.Vertices.size();
-        newMesh.Vertices.emplace_back(oldMesh.Vertices[quad.w]);
+    updateBounds(mesh, vertices);
 
-        Vertex face;
+    // create buffers/arrays
+    glGenVertexArrays(1, &mesh.VAO);
+    glGenBuffers(1, &mesh.VBO);
+    glGenBuffers(1, &mesh.EBO);
 
-        face.Position = 0.25f * (oldMesh.Vertices[quad.x].Position +
-                                 oldMesh.Vertices[quad.y].Position +
-                                 oldMesh.Vertices[quad.z].Position +
-                                 oldMesh.Vertices[quad.w].Position);
+    glBindVertexArray(mesh.VAO);
+    // load data into vertex buffers
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
 
-        face.TexCoord = 0.25f * (oldMesh.Vertices[quad.x].TexCoord +
-                                 oldMesh.Vertices[quad.y].TexCoord +
-                                 oldMesh.Vertices[quad.z].TexCoord +
-                                 oldMesh.Vertices[quad.w].TexCoord);
+    // A great thing about structs is that their memory layout is sequential for all its items.
+    // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+    // again translates to 3/2 floats which translates to a byte array.
+    glBufferData(GL_ARRAY_BUFFER, mesh.VerticesCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);
 
-        Vertex ab;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
 
-        ab.Position = 0.5f * (oldMesh.Vertices[quad.x].Position + oldMesh.Vertices[quad.y].Position);
-        ab.TexCoord = 0.5f * (oldMesh.Vertices[quad.x].TexCoord + oldMesh.Vertices[quad.y].TexCoord);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.QuadsCount * sizeof(glm::uvec4), quads, GL_STATIC_DRAW);
 
-        int32_t abIndex = addNewVertex(newMesh, ab);
+    setupVertexAttributes();
 
-        if (abIndex == -1)
-            throw std::exception("Can't add new AB Vertex");
+    glBindVertexArray(0);
+}
 
-        Vertex bc;
+std::vector<Vertex*> Model::mapStreamedVertices(std::list<Mesh>& level)
+{
+    std::vector<Vertex*> vertices;
+    vertices.reserve(level.size());
 
-        bc.Position = 0.5f * (oldMesh.Vertices[quad.y].Position + oldMesh.Vertices[quad.z].Position);
-        bc.TexCoord = 0.5f * (oldMesh.Vertices[quad.y].TexCoord + oldMesh.Vertices[quad.z].TexCoord);
+    for (Mesh& mesh : level)
+    {
+        // a level that came from the cache has its vertices in the file, one refined to be written to it in the array
+        if (!mesh.File.Vertices)
+            mesh.VerticesCount = mesh.Vertices.empty() ? mesh.Stencils.getStencilsCount() : mesh.Vertices.size();
 
-        int32_t bcIndex = addNewVertex(newMesh, bc);
+        // persistent because the mapping outlives this frame, deformCage still updates the vertices with glBufferSubData
+        GLsizeiptr size = static_cast<GLsizeiptr>(std::max<size_t>(mesh.VerticesCount * sizeof(Vertex), 1));
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT;
 
-        if (bcIndex == -1)
-            throw std::exception("Can't add new BC Vertex");
+        glCreateBuffers(1, &mesh.VBO);
+        glNamedBufferStorage(mesh.VBO, size, nullptr, GL_DYNAMIC_STORAGE_BIT | flags);
 
-        Vertex cd;
+        vertices.push_back(static_cast<Vertex*>(glMapNamedBufferRange(mesh.VBO, 0, size, flags)));
+    }
 
-        cd.Position = 0.5f * (oldMesh.Vertices[quad.z].Position + oldMesh.Vertices[quad.w].Position);
-        cd.TexCoord = 0.5f * (oldMesh.Vertices[quad.z].TexCoord + oldMesh.Vertices[quad.w].TexCoord);
+    return vertices;
+}
 
-        int32_t cdIndex = addNewVertex(newMesh, cd);
+void Model::evaluateStreamedLevel(std::list<Mesh>& level, const std::list<Mesh>& parents, const std::vector<Vertex*>& vertices)
+{
+    auto parent = parents.begin();
+    auto destination = vertices.begin();
 
-        if (cdIndex == -1)
-            throw std::exception("Can't add new CD Vertex");
+    for (Mesh& mesh : level)
+    {
+        const Vertex* cached = mesh.Vertices.empty() ? mesh.File.Vertices : mesh.Vertices.data();
 
-        Vertex da;
+        // the buffer is write-only, bounds are measured on the source
+        if (cached)
+        {
+            std::copy(cached, cached + mesh.VerticesCount, *destination);
+            updateBounds(mesh, cached);
+        }
+        else
+            evaluateVertices(mesh.Stencils, mesh.TexCoordStencils, parent->Vertices, *destination, mesh.BoundsMin, mesh.BoundsMax);
 
-        da.Position = 0.5f * (oldMesh.Vertices[quad.w].Position + oldMesh.Vertices[quad.x].Position);
-        da.TexCoord = 0.5f * (oldMesh.Vertices[quad.w].TexCoord + oldMesh.Vertices[quad.x].TexCoord);
+        mesh.TexCoordStencils = StencilTable();
 
-        int32_t daIndex = addNewVertex(newMesh, da);
+        ++parent;
+        ++destination;
+    }
+}
 
-        if (daIndex == -1)
-            throw std::exception("Can't add new DA Vertex");
+void Model::setupStreamedMesh(Mesh& mesh, const Mesh& parent, unsigned indicesBuffer)
+{
+    mesh.QuadsCount = 4 * getFacesCount(parent);
 
-        int32_t faceIndex = addNewVertex(newMesh, face);
+    // the jobs are done with both buffers, they only have to be unmapped before drawing from them
+    mesh.EBO = indicesBuffer;
+    glUnmapNamedBuffer(mesh.EBO);
+    glUnmapNamedBuffer(mesh.VBO);
 
-        if (faceIndex == -1)
-            throw std::exception("Can't add new Face Vertex");
+    glGenVertexArrays(1, &mesh.VAO);
+    glBindVertexArray(mesh.VAO);
 
-        newMesh.Quads.emplace_back(glm::uvec4(daIndex, a, abIndex, faceIndex));
-        newMesh.Quads.emplace_back(glm::uvec4(abIndex, b, bcIndex, faceIndex));
-        newMesh.Quads.emplace_back(glm::uvec4(bcIndex, c, cdIndex, faceIndex));
-        newMesh.Quads.emplace_back(glm::uvec4(cdIndex, d, daIndex, faceIndex));
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
 
-        std::string aPosStr = vec3ToString(oldMesh.Vertices[quad.x].Position);
-        std::string bPosStr = vec3ToString(oldMesh.Vertices[quad.y].Position);
-        std::string cPosStr = vec3ToString(oldMesh.Vertices[quad.z].Position);
-        std::string dPosStr = vec3ToString(oldMesh.Vertices[quad.w].Position);
+    setupVertexAttributes();
 
-        std::string abPosStr = vec3ToString(ab.Position);
-        std::string bcPosStr = vec3ToString(bc.Position);
-        std::string cdPosStr = vec3ToString(cd.Position);
-        std::string daPosStr = vec3ToString(da.Position);
+    glBindVertexArray(0);
+}
 
-        stringToVec3[abPosStr] = ab.Position;
-        stringToVec3[bcPosStr] = bc.Position;
-        stringToVec3[cdPosStr] = cd.Position;
-        stringToVec3[daPosStr] = da.Position;
+void Model::setupVertexAttributes()
+{
+    // set the vertex attribute pointers
+    // vertex Positions
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
 
-        adjustedEdges[abPosStr] += 0.25f * face.Position;
-        vertexAndEdges[aPosStr].emplace(abPosStr);
-        vertexAndFaces[aPosStr].emplace(faceIndex);
-        vertexAndEdges[bPosStr].emplace(abPosStr);
-        vertexAndFaces[bPosStr].emplace(faceIndex);
+    // vertex texture coords
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoord));
+}
 
-        adjustedEdges[bcPosStr] += 0.25f * face.Position;
-        vertexAndEdges[bPosStr].emplace(bcPosStr);
-        vertexAndFaces[bPosStr].emplace(faceIndex);
-        vertexAndEdges[cPosStr].emplace(bcPosStr);
-        vertexAndFaces[cPosStr].emplace(faceIndex);
+void Model::deleteBuffers(Mesh& mesh)
+{
+    if (mesh.VAO)
+        glDeleteVertexArrays(1, &mesh.VAO);
 
-        adjustedEdges[cdPosStr] += 0.25f * face.Position;
-        vertexAndEdges[cPosStr].emplace(cdPosStr);
-        vertexAndFaces[cPosStr].emplace(faceIndex);
-        vertexAndEdges[dPosStr].emplace(cdPosStr);
-        vertexAndFaces[dPosStr].emplace(faceIndex);
+    if (mesh.VBO)
+        glDeleteBuffers(1, &mesh.VBO);
 
-        adjustedEdges[daPosStr] += 0.25f * face.Position;
-        vertexAndEdges[dPosStr].emplace(daPosStr);
-        vertexAndFaces[dPosStr].emplace(faceIndex);
-        vertexAndEdges[aPosStr].emplace(daPosStr);
-        vertexAndFaces[aPosStr].emplace(faceIndex);
-    }
+    if (mesh.EBO)
+        glDeleteBuffers(1, &mesh.EBO);
+}
+
+void Model::releaseCpuData()
+{
+    for (Mesh& mesh : m_meshes)
+        releaseCpuData(mesh);
 
-    for (Vertex& vertex : newMesh.Vertices)
+    for (std::list<Mesh>& level : m_subdividedMeshes)
     {
-        std::string posStr = vec3ToString(vertex.Position);
+        for (Mesh& mesh : level)
+            releaseCpuData(mesh);
+    }
+}
 
-        if (adjustedEdges.count(posStr))
-            vertex.Position = 0.5f * vertex.Position + adjustedEdges[posStr];
+void Model::releaseCpuData(Mesh& mesh)
+{
+    // meshes that aren't uploaded yet have nothing to read back from
+    if (mesh.VBO == 0)
+        return;
 
-        if (vertexAndEdges.count(posStr))
-        {
-            int n = static_cast<int>(vertexAndFaces[posStr].size());
-            float m3 = static_cast<float>(n - 3) / n;
-            float m2 = 2.0f / n;
-            float m1 = 1.0f / n;
-
-            glm::vec3 faceAvg = glm::vec3(0.0f);
-            for (int32_t posId : vertexAndFaces[posStr])
-                faceAvg += newMesh.Vertices[posId].Position;
-            faceAvg /= vertexAndFaces[posStr].size();
-
-            glm::vec3 edgeAvg = glm::vec3(0.0f);
-            for (const std::string& str : vertexAndEdges[posStr])
-                edgeAvg += stringToVec3[str];
-            edgeAvg /= vertexAndEdges[posStr].size();
-
-            vertex.Position = m1 * faceAvg + m2 * edgeAvg + m3 * vertex.Position;
-        }
-    }
+    std::vector<Vertex>().swap(mesh.Vertices);
+    std::vector<glm::uvec4>().swap(mesh.Quads);
+    mesh.File = MeshFileArrays();
+
+    mesh.Topology     = decltype(mesh.Topology)();
+    mesh.Stencils     = StencilTable();
+    mesh.CageStencils = StencilTable();
 }
 
-int32_t Model::addNewVertex(Mesh& mesh, Vertex& vertex)
+void Model::restoreCpuData(Mesh& mesh)
 {
-    int32_t index = -1;
-    auto pos = std::find_if(mesh.Vertices.begin(), mesh.Vertices.end(),
-        [&vertex](const Vertex& v) { return v.Position == vertex.Position && v.TexCoord == vertex.TexCoord; });
+    // a mesh still mapped from its file is copied out of it, the buffers are only read when it's gone
+    MeshModel::restoreCpuData(mesh);
 
-    if (pos == mesh.Vertices.end())
+    if (mesh.Vertices.empty() && mesh.VerticesCount > 0)
     {
-        index = static_cast<int32_t>(mesh.Vertices.size());
-        mesh.Vertices.emplace_back(vertex);
+        mesh.Vertices.resize(mesh.VerticesCount);
+        glGetNamedBufferSubData(mesh.VBO, 0, mesh.VerticesCount * sizeof(Vertex), mesh.Vertices.data());
     }
-    else
-        index = static_cast<int32_t>(pos - mesh.Vertices.begin());
 
-    return index;
+    if (mesh.Quads.empty() && mesh.QuadsCount > 0)
+    {
+        mesh.Quads.resize(mesh.QuadsCount);
+        glGetNamedBufferSubData(mesh.EBO, 0, mesh.QuadsCount * sizeof(glm::uvec4), mesh.Quads.data());
+    }
 }
 
-std::string Model::vec3ToString(const glm::vec3& vec3)
+DrawRecord Model::bakeDrawRecord(const Mesh& mesh) const
 {
-    return std::to_string(vec3.x).append("|") + std::to_string(vec3.y).append("|") + std::to_string(vec3.z);
+    DrawRecord record;
+    record.VAO = mesh.VAO;
+    record.IndicesCount = 4 * static_cast<unsigned>(mesh.QuadsCount);
+    record.Textures.reserve(mesh.Textures.size());
+
+    // retrieve texture number (the N in diffuse_N)
+    unsigned diffuseNr = 1;
+    unsigned specularNr = 1;
+    unsigned normalNr = 1;
+    unsigned heightNr = 1;
+
+    for (const Texture& texture : mesh.Textures)
+    {
+        std::string sampler;
+
+        if (texture.Type == aiTextureType_DIFFUSE)
+            sampler = std::string("diffuse_").append(std::to_string(diffuseNr++));
+        else if (texture.Type == aiTextureType_SPECULAR)
+            sampler = std::string("specular_").append(std::to_string(specularNr++));
+        else if (texture.Type == aiTextureType_HEIGHT)
+            sampler = std::string("normal_").append(std::to_string(normalNr++));
+        else if (texture.Type == aiTextureType_AMBIENT)
+            sampler = std::string("height_").append(std::to_string(heightNr++));
+        else
+            continue;
+
+        // units are fixed by the shared program, samplers it doesn't use have none and their textures are never bound
+        int unit = m_shader->getSamplerUnit(sampler.c_str());
+
+        if (unit >= 0)
+            record.Textures.push_back(TextureBinding { static_cast<unsigned>(unit), texture.Id });
+    }
+
+    return record;
 }
 
-const size_t Model::getVerticesCount(EModelViewType viewType) const
+const size_t Model::getVerticesCount(EModelViewType viewType, unsigned level) const
 {
     size_t total = 0;
 
     if (viewType == EModelViewType::EOriginal)
     {
         for (const Mesh& mesh : m_meshes)
-            total += mesh.Vertices.size();
+            total += mesh.VerticesCount;
 
         return total;
     }
 
-    for (const Mesh& mesh : m_subdividedMeshes)
-        total += mesh.Vertices.size();
+    if (level == 0 || level > m_subdividedMeshes.size())
+        return total;
+
+    for (const Mesh& mesh : m_subdividedMeshes[level - 1])
+        total += mesh.VerticesCount;
 
     return total;
 }
 
-const size_t Model::getQuadsCount(EModelViewType viewType) const
+const size_t Model::getQuadsCount(EModelViewType viewType, unsigned level) const
 {
     size_t total = 0;
 
     if (viewType == EModelViewType::EOriginal)
     {
         for (const Mesh& mesh : m_meshes)
-            total += mesh.Quads.size();
+            total += mesh.QuadsCount;
 
         return total;
     }
 
-    for (const Mesh& mesh : m_subdividedMeshes)
-        total += mesh.Quads.size();
+    if (level == 0 || level > m_subdividedMeshes.size())
+        return total;
+
+    for (const Mesh& mesh : m_subdividedMeshes[level - 1])
+        total += mesh.QuadsCount;
 
     return total;
 }
+
+void Model::getBounds(EModelViewType viewType, unsigned level, glm::vec3& min, glm::vec3& max) const
+{
+    min = glm::vec3(std::numeric_limits<float>::max());
+    max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    const std::list<Mesh>* meshes = &m_meshes;
+
+    if (viewType == EModelViewType::ESubdiveded)
+    {
+        if (level == 0 || level > m_subdividedMeshes.size())
+            return;
+
+        meshes = &m_subdividedMeshes[level - 1];
+    }
+
+    for (const Mesh& mesh : *meshes)
+    {
+        if (mesh.VerticesCount == 0)
+            continue;
+
+        min = glm::min(min, mesh.BoundsMin);
+        max = glm::max(max, mesh.BoundsMax);
+    }
+}
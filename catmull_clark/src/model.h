@@ -2,25 +2,20 @@
 #ifndef CATMULL_CLARK_SUBDIVITION_MODEL_H_
 #define CATMULL_CLARK_SUBDIVITION_MODEL_H_
 
-#include <exception>
-#include <map>
+#include <future>
 #include <list>
-#include <set>
+#include <map>
+#include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "job_progress.h"
+#include "mesh_model.h"
 #include "shader.h"
 
-struct aiNode;
-struct aiMesh;
-struct aiScene;
-struct aiMaterial;
-enum aiTextureType;
-
 namespace CatmullClarkSubdivision
 {
     enum class EModelViewType
@@ -29,32 +24,23 @@ namespace CatmullClarkSubdivision
         ESubdiveded
     };
 
-    struct Vertex
-    {
-        Vertex() : Position{ glm::vec3(0.0f) }, TexCoord{ glm::vec2(0.0f) } { }
-
-        glm::vec3 Position;
-        glm::vec2 TexCoord;
-    };
-
-    struct Texture
+    // texture unit and what is bound to it, the sampler reading the unit is set up when the record is baked
+    struct TextureBinding
     {
-        unsigned      Id;
-        aiTextureType Type;
-        std::string   Path;
+        unsigned Unit;
+        unsigned Id;
     };
 
-    struct Mesh
+    // everything draw needs for one mesh, baked once when its buffers are created
+    struct DrawRecord
     {
-        std::vector<Vertex>     Vertices;
-        std::vector<glm::uvec4> Quads;
-        std::list<Texture>      Textures;
         unsigned VAO;
-        unsigned VBO;
-        unsigned EBO;
+        unsigned IndicesCount;
+        std::vector<TextureBinding> Textures;
     };
 
-    class Model
+    // a MeshModel with a GL side: uploads, draws and refines its levels in a background job
+    class Model : public MeshModel
     {
     public:
         Model() { }
@@ -65,11 +51,42 @@ namespace CatmullClarkSubdivision
         Model& operator=(const Model& other) = delete;
         Model& operator=(Model&& other)      = delete;
 
-        void loadModel(const char* path, glm::mat4 projection, glm::mat4 view);
-        void draw(EModelViewType viewType);
-
-        const size_t getVerticesCount(EModelViewType viewType) const;
-        const size_t getQuadsCount(EModelViewType viewType) const;
+        // importModel, decodeTextures and uploadModel
+        void loadModel(const char* path);
+        // reads and decodes every texture the imported meshes name, fine on any thread. Only drawing needs them,
+        // conversion and benchmarks leave it out
+        void decodeTextures();
+        // a GPU-resident model reads its arrays back from the buffers to write them
+        void exportModel(const char* path) override;
+        // GL side of loading, on the thread owning the context: textures, buffers and the shader
+        void uploadModel();
+        void draw(EModelViewType viewType, unsigned level = 1);
+
+        // refines every level up to the given one that isn't cached yet in a background job, without blocking.
+        // Levels are uploaded by the first call that finds the job finished. Returns whether the level can be drawn,
+        // until then draw falls back to the original meshes
+        bool subdivide(unsigned level);
+        // blocks until the running job is done and uploads its levels
+        void waitSubdivision();
+        // asks the running job to stop, whatever it refined is dropped once it returns
+        void cancelSubdivision();
+
+        bool isSubdividing() const { return m_subdivisionJob.valid(); }
+        // faces refined by the running job
+        const JobProgress& getSubdivisionProgress() const { return m_subdivisionProgress; }
+
+        // moves the original vertices of a mesh and re-evaluates every cached level from precomputed stencils
+        void deformCage(size_t meshIndex, const std::vector<glm::vec3>& positions);
+
+        const size_t getVerticesCount(EModelViewType viewType, unsigned level = 1) const;
+        const size_t getQuadsCount(EModelViewType viewType, unsigned level = 1) const;
+        // box around every mesh of the level in model space, empty before upload
+        void getBounds(EModelViewType viewType, unsigned level, glm::vec3& min, glm::vec3& max) const;
+
+        // opt-in: uploaded meshes keep only their counts and bounds on the CPU. Vertices and indices are read back
+        // from their GL buffers when refinement or deformation needs them, topology and stencils are rebuilt
+        void setGpuResident(bool isResident);
+        bool isGpuResident() const { return m_isGpuResident; }
 
         const float getScale() const  { return m_scale; }
         const float getAngleX() const { return m_rotation.x; }
@@ -83,23 +100,39 @@ namespace CatmullClarkSubdivision
         void rotateZ(float theta) { m_rotation.z = theta; }
 
     private:
-        void processNode(aiNode* node, const aiScene* scene);
-        void processMesh(aiMesh* mesh, const aiScene* scene);
-
-        std::list<Texture> loadMaterialTextures(aiMaterial* material, aiTextureType type);
-        unsigned textureFromFile(const char* path);
-
-        std::list<Mesh> m_meshes;
-        std::list<Mesh> m_subdividedMeshes;
-        std::set<const char*> m_loadedTextures;
-
-        void applySubdivision(Mesh& oldMesh, Mesh& newMesh);
-        int32_t addNewVertex(Mesh& mesh, Vertex& vertex);
-        std::string vec3ToString(const glm::vec3& vec3);
-
-        Shader m_shader;
-
-        std::string m_modelDir = "";
+        void setupMesh(Mesh& mesh);
+        // creates and maps the vertex buffers of the job's last level, sized from its stencils or its cached vertices
+        std::vector<Vertex*> mapStreamedVertices(std::list<Mesh>& level);
+        // job side of the above, evaluates every mesh of the level right into its mapped buffer
+        static void evaluateStreamedLevel(std::list<Mesh>& level, const std::list<Mesh>& parents, const std::vector<Vertex*>& vertices);
+        // the jobs already wrote the vertices and quads into the buffers, they are unmapped and get their vertex array
+        void setupStreamedMesh(Mesh& mesh, const Mesh& parent, unsigned indicesBuffer);
+        static void setupVertexAttributes();
+        // meshes never uploaded, when converting or benchmarking without a context, have nothing to delete
+        static void deleteBuffers(Mesh& mesh);
+        // drops the arrays of every uploaded mesh, what is left is enough to draw and to read them back
+        void releaseCpuData();
+        void releaseCpuData(Mesh& mesh);
+        void restoreCpuData(Mesh& mesh);
+        DrawRecord bakeDrawRecord(const Mesh& mesh) const;
+
+        std::vector<std::list<Mesh>> m_subdividedMeshes; // index is level - 1
+        std::vector<DrawRecord> m_drawRecords;
+        std::vector<std::vector<DrawRecord>> m_subdividedDrawRecords; // index is level - 1
+        std::future<std::vector<std::list<Mesh>>> m_subdivisionJob; // next levels, refined but not uploaded
+        JobProgress m_subdivisionProgress;
+        std::vector<unsigned> m_streamedBuffers; // index buffers of the job's last level, mapped until collected
+        bool m_isStreamEvaluating = false; // the job has the levels back to evaluate the last one into its vertex buffers
+        std::map<std::string, std::string> m_textures; // file name -> TextureCache key, one reference held per file
+
+        void collectSubdivision(bool wait);
+        // taken from the cache when it has the level, written to it otherwise
+        std::list<Mesh> refineLevel(unsigned level, std::list<Mesh>& source, const std::vector<glm::uvec4*>& streamedQuads = std::vector<glm::uvec4*>());
+
+        std::shared_ptr<Shader> m_shader; // shared with every model built from the same sources
+        Uniform<glm::mat4> m_modelUniform;
+
+        bool m_isGpuResident = false;
 
         glm::vec3 m_position = glm::vec3(0.0f);
         glm::vec3 m_rotation = glm::vec3(0.0f);
@@ -0,0 +1,117 @@
+#include "topology.h"
+
+#include <unordered_map>
+
+#include "vertex_welder.h"
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    uint64_t edgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+}
+
+const uint32_t HalfEdgeTopology::INVALID_INDEX;
+
+void HalfEdgeTopology::build(const std::vector<Vertex>& vertices, const std::vector<glm::uvec4>& quads, float weldTolerance)
+{
+    VertexPoints.assign(vertices.size(), INVALID_INDEX);
+    PointVertices.clear();
+    PointVertices.reserve(vertices.size());
+
+    VertexWelder welder(weldTolerance);
+    welder.reserve(vertices.size());
+
+    for (uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        VertexPoints[i] = welder.weld(vertices[i].Position);
+
+        if (VertexPoints[i] == PointVertices.size())
+            PointVertices.push_back(i);
+    }
+
+    size_t halfEdgesCount = 4 * quads.size();
+
+    Origins.resize(halfEdgesCount);
+    Twins.assign(halfEdgesCount, INVALID_INDEX);
+    Edges.resize(halfEdgesCount);
+    EdgeHalves.clear();
+    EdgeHalves.reserve(halfEdgesCount / 2 + 1);
+
+    std::unordered_map<uint64_t, uint32_t> edges;
+    edges.reserve(halfEdgesCount / 2 + 1);
+
+    for (uint32_t f = 0; f < quads.size(); ++f)
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+            Origins[4 * f + i] = VertexPoints[quads[f][i]];
+    }
+
+    for (uint32_t h = 0; h < halfEdgesCount; ++h)
+    {
+        uint64_t key = edgeKey(Origins[h], Origins[next(h)]);
+
+        auto inserted = edges.emplace(key, static_cast<uint32_t>(EdgeHalves.size()));
+        if (inserted.second)
+        {
+            Edges[h] = inserted.first->second;
+            EdgeHalves.push_back(h);
+            continue;
+        }
+
+        uint32_t edge = inserted.first->second;
+        uint32_t other = EdgeHalves[edge];
+
+        if (Twins[other] == INVALID_INDEX)
+        {
+            Twins[other] = h;
+            Twins[h] = other;
+            Edges[h] = edge;
+        }
+        else
+        {
+            // non-manifold edge: every extra face gets its own boundary edge
+            Edges[h] = static_cast<uint32_t>(EdgeHalves.size());
+            EdgeHalves.push_back(h);
+        }
+    }
+
+    // point adjacency in CSR form: count, prefix sum, then scatter
+    const uint32_t pointsCount = getPointsCount();
+
+    RingOffsets.assign(pointsCount + 1, 0);
+    CornerOffsets.assign(pointsCount + 1, 0);
+
+    for (uint32_t h : EdgeHalves)
+    {
+        ++RingOffsets[Origins[h] + 1];
+        ++RingOffsets[Origins[next(h)] + 1];
+    }
+
+    for (uint32_t point : Origins)
+        ++CornerOffsets[point + 1];
+
+    for (uint32_t p = 0; p < pointsCount; ++p)
+    {
+        RingOffsets[p + 1] += RingOffsets[p];
+        CornerOffsets[p + 1] += CornerOffsets[p];
+    }
+
+    RingEdges.resize(RingOffsets[pointsCount]);
+    Corners.resize(CornerOffsets[pointsCount]);
+
+    std::vector<uint32_t> ringCursor(RingOffsets.begin(), RingOffsets.end() - 1);
+    std::vector<uint32_t> cornerCursor(CornerOffsets.begin(), CornerOffsets.end() - 1);
+
+    for (uint32_t e = 0; e < EdgeHalves.size(); ++e)
+    {
+        RingEdges[ringCursor[Origins[EdgeHalves[e]]]++] = e;
+        RingEdges[ringCursor[Origins[next(EdgeHalves[e])]]++] = e;
+    }
+
+    for (uint32_t h = 0; h < halfEdgesCount; ++h)
+        Corners[cornerCursor[Origins[h]]++] = h;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_TOPOLOGY_H_
+#define CATMULL_CLARK_SUBDIVITION_TOPOLOGY_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vertex.h"
+
+namespace CatmullClarkSubdivision
+{
+    // Half-edge connectivity of a quad mesh. Half-edges are stored implicitly per face: half-edge 4 * f + i
+    // starts at corner i of face f and ends at corner (i + 1) % 4, so face/next/prev are plain bit operations.
+    // Vertices that share a position (e.g. split along a texture seam) are welded into one point, so smoothing
+    // sees one continuous surface while every face corner still references its own textured vertex.
+    struct HalfEdgeTopology
+    {
+        static const uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+        // positions closer than weldTolerance are welded into one point, zero welds bit-identical positions only
+        void build(const std::vector<Vertex>& vertices, const std::vector<glm::uvec4>& quads, float weldTolerance = 0.0f);
+
+        static uint32_t face(uint32_t halfEdge) { return halfEdge >> 2; }
+        static uint32_t next(uint32_t halfEdge) { return (halfEdge & ~3u) | ((halfEdge + 1) & 3u); }
+        static uint32_t prev(uint32_t halfEdge) { return (halfEdge & ~3u) | ((halfEdge + 3) & 3u); }
+
+        uint32_t getFacesCount() const     { return static_cast<uint32_t>(Origins.size() >> 2); }
+        uint32_t getHalfEdgesCount() const { return static_cast<uint32_t>(Origins.size()); }
+        uint32_t getEdgesCount() const     { return static_cast<uint32_t>(EdgeHalves.size()); }
+        uint32_t getPointsCount() const    { return static_cast<uint32_t>(PointVertices.size()); }
+
+        bool isBoundary(uint32_t edge) const { return Twins[EdgeHalves[edge]] == INVALID_INDEX; }
+
+        // calls visitor on every array below in a fixed order, the mesh cache stores them that way
+        template <typename Visitor>
+        void forEachArray(Visitor visitor)
+        {
+            visitor(VertexPoints);
+            visitor(PointVertices);
+            visitor(Origins);
+            visitor(Twins);
+            visitor(Edges);
+            visitor(EdgeHalves);
+            visitor(RingOffsets);
+            visitor(RingEdges);
+            visitor(CornerOffsets);
+            visitor(Corners);
+        }
+
+        std::vector<uint32_t> VertexPoints;  // mesh vertex -> welded point
+        std::vector<uint32_t> PointVertices; // welded point -> first mesh vertex with that position
+
+        std::vector<uint32_t> Origins;       // half-edge -> welded point it starts from
+        std::vector<uint32_t> Twins;         // half-edge -> opposite half-edge or INVALID_INDEX on boundary
+        std::vector<uint32_t> Edges;         // half-edge -> edge
+        std::vector<uint32_t> EdgeHalves;    // edge -> one of its half-edges
+
+        // edges around point p are RingEdges[RingOffsets[p] .. RingOffsets[p + 1]),
+        // half-edges leaving it (one per incident face) are Corners[CornerOffsets[p] .. CornerOffsets[p + 1])
+        std::vector<uint32_t> RingOffsets;
+        std::vector<uint32_t> RingEdges;
+        std::vector<uint32_t> CornerOffsets;
+        std::vector<uint32_t> Corners;
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_TOPOLOGY_H_
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 
 #undef APIENTRY
 #include <glad/glad.h>
@@ -10,6 +11,9 @@
 #include <imgui/imgui_impl_sdl.h>
 #include <imgui/imgui_impl_opengl3.h>
 
+#include "shader_cache.h"
+#include "texture_cache.h"
+#include "thread_pool.h"
 #include "utils.h"
 
 using namespace CatmullClarkSubdivision;
@@ -57,15 +61,28 @@ void Engine::init()
 
     glEnable(GL_DEPTH_TEST);
 
-    addModel("resources\\banana\\banana.obj", "Banana");
-    addModel("resources\\bunny\\bunny.obj", "Bunny");
-    m_models["Bunny"]->scale(0.05f);
+    // linked programs are kept next to their sources, later starts skip GLSL compilation
+    ShaderCache::getInstance().setBinaryDirectory(getFileFullPath("shaders"));
+
+    // imported and refined meshes too, a warm start maps them instead of importing and refining again
+    m_meshCacheDirectory = getFileFullPath("cache");
+    createDirectory(m_meshCacheDirectory);
 
-    addModel("resources\\cube\\cube.obj", "Cube");
-    addModel("resources\\hamburger\\hamburger.obj", "Hamburger");
-    addModel("resources\\head\\head.obj", "Head");
-    addModel("resources\\ice_cream\\ice_cream.obj", "IceCream");
-    addModel("resources\\torus\\torus.obj", "Torus");
+    m_camera.create();
+    m_camera.setProjection(glm::perspective(glm::radians(45.0f),
+        static_cast<float>(INITIAL_WIDTH) / static_cast<float>(INITIAL_HEIGHT),
+        0.1f, 100.0f));
+    m_camera.setView(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.25f, -3.0f)));
+
+    addModels({ { "resources\\banana\\banana.obj",       "Banana" },
+                { "resources\\bunny\\bunny.obj",         "Bunny" },
+                { "resources\\cube\\cube.obj",           "Cube" },
+                { "resources\\hamburger\\hamburger.obj", "Hamburger" },
+                { "resources\\head\\head.obj",           "Head" },
+                { "resources\\ice_cream\\ice_cream.obj", "IceCream" },
+                { "resources\\torus\\torus.obj",         "Torus" } });
+
+    m_models["Bunny"]->scale(0.05f);
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
@@ -92,6 +109,8 @@ void Engine::release()
     for (auto& model : m_models)
         delete model.second;
 
+    m_camera.release();
+
     SDL_GL_DeleteContext(m_context);
 
     if (m_window)
@@ -182,8 +201,16 @@ void Engine::update()
 
     if (ImGui::Begin("Setup", nullptr, ImGuiWindowFlags_NoCollapse))
     {
-        ImGui::SetWindowSize(ImVec2(300.0f, 160.0f));
+        ImGui::SetWindowSize(ImVec2(300.0f, m_models[values[idx]]->isSubdividing() ? 255.0f : 185.0f));
         ImGui::Checkbox("Wireframe", &m_wireframe);
+        ImGui::SameLine();
+
+        // CPU copies of every mesh are dropped after upload and read back only when needed
+        if (ImGui::Checkbox("GPU resident", &m_isGpuResident))
+        {
+            for (auto& model : m_models)
+                model.second->setGpuResident(m_isGpuResident);
+        }
 
         int type = static_cast<int>(m_type);
         ImGui::RadioButton("Original", &type, 0);
@@ -191,8 +218,14 @@ void Engine::update()
         ImGui::RadioButton("Subdivided", &type, 1);
         m_type = static_cast<EModelViewType>(type);
 
+        int level = static_cast<int>(m_level);
+        ImGui::SliderInt("Level", &level, 1, Model::MAX_SUBDIVISION_LEVEL);
+        m_level = static_cast<unsigned>(level);
+
         ImGui::Separator();
 
+        size_t previous = idx;
+
         if (ImGui::BeginCombo("Models", values[idx], ImGuiComboFlags_PopupAlignLeft))
         {
             for (int n = 0; n < values.size(); ++n)
@@ -208,10 +241,29 @@ void Engine::update()
             ImGui::EndCombo();
         }
 
+        // the job of a model that isn't shown anymore only takes time from the one that is
+        if (idx != previous)
+            m_models[values[previous]]->cancelSubdivision();
+
         ImGui::Separator();
 
-        ImGui::Text("Vertices: %d", m_models[values[idx]]->getVerticesCount(m_type));
-        ImGui::Text("Triangles: %d", m_models[values[idx]]->getTrianglesCount(m_type));
+        ImGui::Text("Vertices: %d", m_models[values[idx]]->getVerticesCount(m_type, m_level));
+        ImGui::Text("Triangles: %d", m_models[values[idx]]->getTrianglesCount(m_type, m_level));
+
+        if (m_models[values[idx]]->isSubdividing())
+        {
+            const JobProgress& progress = m_models[values[idx]]->getSubdivisionProgress();
+            double remaining = progress.getRemainingSeconds();
+
+            ImGui::Separator();
+            ImGui::ProgressBar(progress.getFraction());
+            ImGui::Text("Faces: %llu / %llu", static_cast<unsigned long long>(progress.getDone()), static_cast<unsigned long long>(progress.getTotal()));
+
+            if (remaining >= 0.0)
+                ImGui::Text("ETA: %.1f s", remaining);
+            else
+                ImGui::Text("ETA: -");
+        }
 
         ImGui::End();
     }
@@ -222,7 +274,16 @@ void Engine::update()
     model->rotateY(model->getAngleY() + rotation.y);
     model->scale(model->getScale() * scale);
 
-    model->draw(m_type);
+    if (m_type == EModelViewType::ESubdiveded)
+        model->subdivide(m_level);
+
+    // one upload at most, however many programs read the camera
+    m_camera.bind();
+
+    // textures still loading draw with their placeholder
+    TextureCache::getInstance().update();
+
+    model->draw(m_type, m_level);
 
     if (m_wireframe)
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -237,16 +298,36 @@ void Engine::update()
 
 void Engine::addModel(const char* path, const char* name)
 {
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f),
-        static_cast<float>(INITIAL_WIDTH) / static_cast<float>(INITIAL_HEIGHT),
-        0.1f, 100.0f);
+    addModels({ { path, name } });
+}
+
+void Engine::addModels(const std::vector<std::pair<const char*, const char*>>& models)
+{
+    std::vector<std::unique_ptr<Model>> loaded(models.size());
+    for (std::unique_ptr<Model>& model : loaded)
+    {
+        model.reset(new Model);
+        model->setCacheDirectory(m_meshCacheDirectory);
+    }
 
-    glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.25f, -3.0f));
+    // import, decoding and subdivision of every model run on the pool, the GL context stays on this thread
+    ThreadPool::getInstance().parallelFor(static_cast<uint32_t>(models.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            loaded[i]->importModel(getFileFullPath(models[i].first).c_str());
+            loaded[i]->decodeTextures();
+        }
+    });
 
-    Model* model = new Model;
-    model->loadModel(getFileFullPath(path).c_str(), projection, view);
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        loaded[i]->uploadModel();
 
-    m_models[ std::string(name) ] = model;
+        Model*& model = m_models[ std::string(models[i].second) ];
+        delete model;
+        model = loaded[i].release();
+    }
 }
 
 void Engine::setTitle(const char* title)
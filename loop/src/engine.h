@@ -3,9 +3,12 @@
 #define CATMULL_CLARK_SUBDIVITION_SDL2_H_
 
 #include <map>
+#include <utility>
+#include <vector>
 
 #include <sdl2/SDL.h>
 
+#include "camera_buffer.h"
 #include "model.h"
 
 namespace CatmullClarkSubdivision
@@ -32,6 +35,8 @@ namespace CatmullClarkSubdivision
         void setTitle(const char* title);
 
         void addModel(const char* path, const char* name);
+        // loads the models in parallel, pairs are path and name
+        void addModels(const std::vector<std::pair<const char*, const char*>>& models);
 
         Model* getModel(const char* name) { return m_models[name]; }
 
@@ -52,9 +57,13 @@ namespace CatmullClarkSubdivision
         SDL_Event m_event { SDL_FIRSTEVENT };
 
         std::map<std::string, Model*> m_models;
+        CameraBuffer m_camera;
+        std::string m_meshCacheDirectory;
 
         bool m_wireframe = true;
+        bool m_isGpuResident = false;
         EModelViewType m_type = EModelViewType::EOriginal;
+        unsigned m_level = 1;
 
         bool m_isWindowClosed = false;
         bool m_isInit         = false;
@@ -0,0 +1,783 @@
+#include "mesh_model.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "mesh_cache.h"
+#include "obj_reader.h"
+#include "thread_pool.h"
+
+using namespace CatmullClarkSubdivision;
+
+const unsigned MeshModel::MAX_SUBDIVISION_LEVEL;
+namespace
+{
+    // part of the cache file names, levels of the other scheme never match
+    const char* const SUBDIVISION_SCHEME = "loop";
+
+    // materials name texture files relative to the model, whatever directory they were exported from
+    std::string getFileName(const std::string& path)
+    {
+        size_t separator = path.find_last_of("/\\");
+        return separator == std::string::npos ? path : path.substr(separator + 1);
+    }
+
+    bool isObjFile(const std::string& path)
+    {
+        std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : std::string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        return extension == ".obj";
+    }
+}
+
+const uint32_t MeshModel::TRIANGLES_GRAIN;
+
+void MeshModel::importModel(const char* path)
+{
+    // retrieve the directory path of the filepath
+    std::string temp(path);
+    if (temp.find_last_of('/') != std::string::npos)
+        m_modelDir = temp.substr(0, temp.find_last_of('/'));
+    else if (temp.find_last_of('\\') != std::string::npos)
+        m_modelDir = temp.substr(0, temp.find_last_of('\\'));
+
+    if (!m_cacheDirectory.empty())
+        m_isSourceHashed = hashFile(path, m_sourceHash);
+
+    // binary mesh files need no parsing, and a warm start doesn't touch assimp at all
+    if (isMeshFile(path))
+    {
+        if (!readMeshes(path, m_meshes, nullptr, std::vector<glm::uvec3*>()))
+            throw std::runtime_error(std::string("Not a valid mesh file for this scheme: ").append(path).c_str());
+    }
+    else if (!loadLevel(0, m_meshes, nullptr, std::vector<glm::uvec3*>()))
+    {
+        // OBJ, the format of every bundled model, has its own reader, assimp stays for anything else
+        if (!importObj(path))
+            importScene(path);
+
+        saveLevel(0, m_meshes);
+    }
+}
+
+void MeshModel::importScene(const char* path)
+{
+    // read file via ASSIMP
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path, aiProcess_JoinIdenticalVertices |
+                                                   aiProcess_Triangulate           |
+                                                   aiProcess_FlipUVs);
+
+    // check for errors
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        throw std::runtime_error(std::string("ASSIMP: ").append(importer.GetErrorString()).c_str());
+
+    // process ASSIMP's root node recursively
+    std::vector<aiMesh*> sources;
+    processNode(scene->mRootNode, scene, sources);
+
+    // meshes are extracted as independent tasks, subdivision waits until a level is first asked for
+    std::vector<Mesh> meshes(sources.size());
+
+    ThreadPool::getInstance().parallelFor(static_cast<uint32_t>(sources.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            processMesh(sources[i], meshes[i]);
+    });
+
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        meshes[i].Textures = processMaterial(scene->mMaterials[sources[i]->mMaterialIndex]);
+        m_meshes.emplace_back(std::move(meshes[i]));
+    }
+}
+
+bool MeshModel::importObj(const char* path)
+{
+    std::vector<ObjMesh> sources;
+    if (!isObjFile(path) || !readObj(path, sources))
+        return false;
+
+    std::vector<Mesh> meshes(sources.size());
+
+    ThreadPool::getInstance().parallelFor(static_cast<uint32_t>(sources.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            processMesh(sources[i], meshes[i]);
+    });
+
+    for (Mesh& mesh : meshes)
+        m_meshes.emplace_back(std::move(mesh));
+
+    return true;
+}
+
+void MeshModel::exportModel(const char* path)
+{
+    for (Mesh& mesh : m_meshes)
+        restoreCpuData(mesh);
+
+    if (!writeMeshes(path, m_meshes, true))
+        throw std::runtime_error(std::string("Failed to write mesh file: ").append(path).c_str());
+}
+
+// processes a node in a recursive fashion. Collects each individual mesh located at the node and repeats this process on its children nodes (if any).
+void MeshModel::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& meshes)
+{
+    // process each mesh located at the current node
+    for (unsigned i = 0; i < node->mNumMeshes; ++i)
+    {
+        // the node object only contains indices to index the actual objects in the scene. 
+        // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+        meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+    }
+    // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+    for (unsigned i = 0; i < node->mNumChildren; ++i)
+        processNode(node->mChildren[i], scene, meshes);
+}
+
+// extracts vertices and faces only, it doesn't touch GL so meshes can be processed concurrently
+void MeshModel::processMesh(aiMesh* mesh, Mesh& newMesh)
+{
+    newMesh.Vertices.reserve(mesh->mNumVertices);
+    newMesh.Triangles.reserve(mesh->mNumFaces);
+
+    // walk through each of the mesh's vertices
+    for (unsigned i = 0; i < mesh->mNumVertices; ++i)
+    {
+        Vertex vertex { };
+        vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+
+        // texture coordinates
+        if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+        {
+            // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't 
+            // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
+            vertex.TexCoord = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+        }
+        else
+            vertex.TexCoord = glm::vec2(-1.0f);
+
+        newMesh.Vertices.push_back(vertex);
+    }
+
+    // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+    for (unsigned i = 0; i < mesh->mNumFaces; ++i)
+    {
+        aiFace face = mesh->mFaces[i];
+
+        if (face.mNumIndices != 3)
+            throw std::runtime_error(std::string("Model doesn't have correct number of indices (need 3): ").append(std::to_string(face.mNumIndices)).c_str());
+
+        // retrieve all indices of the face and store them in the indices vector
+        newMesh.Triangles.emplace_back(glm::uvec3(face.mIndices[0], face.mIndices[1], face.mIndices[2]));
+    }
+}
+
+// OBJ meshes come welded already, only the faces are converted
+void MeshModel::processMesh(ObjMesh& mesh, Mesh& newMesh)
+{
+    newMesh.Vertices = std::move(mesh.Vertices);
+
+    newMesh.Triangles.reserve(mesh.getFacesCount());
+
+    for (uint32_t i = 0; i < mesh.getFacesCount(); ++i)
+    {
+        const uint32_t* corners = &mesh.Corners[mesh.FaceOffsets[i]];
+        uint32_t count = mesh.FaceOffsets[i + 1] - mesh.FaceOffsets[i];
+
+        if (count < 3)
+            throw std::runtime_error(std::string("Model doesn't have correct number of indices (need 3): ").append(std::to_string(count)).c_str());
+
+        // polygons are fanned from their first corner, as aiProcess_Triangulate does with convex ones
+        for (uint32_t j = 1; j + 1 < count; ++j)
+            newMesh.Triangles.emplace_back(glm::uvec3(corners[0], corners[j], corners[j + 1]));
+    }
+
+    newMesh.Textures = processMaterial(mesh.Material);
+}
+
+std::list<Texture> MeshModel::processMaterial(aiMaterial* material)
+{
+    std::list<Texture> textures;
+    // 1. diffuse maps
+    std::list<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE);
+    textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+    // 2. specular maps
+    std::list<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR);
+    textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+    // 3. normal maps
+    std::list<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT);
+    textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+    // 4. height maps
+    std::list<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT);
+    textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+
+    return textures;
+}
+
+// the types and order of the assimp materials, the OBJ importer takes bump maps for height maps too
+std::list<Texture> MeshModel::processMaterial(const ObjMaterial& material)
+{
+    const std::pair<aiTextureType, const std::string*> maps[] = { { aiTextureType_DIFFUSE,  &material.DiffuseMap },
+                                                                  { aiTextureType_SPECULAR, &material.SpecularMap },
+                                                                  { aiTextureType_HEIGHT,   &material.BumpMap },
+                                                                  { aiTextureType_AMBIENT,  &material.AmbientMap } };
+
+    std::list<Texture> textures;
+    for (const auto& map : maps)
+    {
+        if (!map.second->empty())
+            textures.push_back(Texture { 0, map.first, getFileName(*map.second) });
+    }
+
+    return textures;
+}
+
+bool MeshModel::loadLevel(unsigned level, std::list<Mesh>& meshes, const std::list<Mesh>* parents, const std::vector<glm::uvec3*>& streamedTriangles)
+{
+    if (!isCacheEnabled())
+        return false;
+
+    return readMeshes(getMeshCachePath(m_cacheDirectory, m_sourceHash, getSchemeName(), level), meshes, parents, streamedTriangles);
+}
+
+void MeshModel::saveLevel(unsigned level, std::list<Mesh>& meshes)
+{
+    // a failed write only costs the next start a refinement
+    if (isCacheEnabled())
+        writeMeshes(getMeshCachePath(m_cacheDirectory, m_sourceHash, getSchemeName(), level), meshes, level == 0);
+}
+
+bool MeshModel::readMeshes(const std::string& path, std::list<Mesh>& meshes, const std::list<Mesh>* parents, const std::vector<glm::uvec3*>& streamedTriangles)
+{
+    // shared by the meshes, the file stays mapped until the last of them has its arrays copied out
+    std::shared_ptr<MeshCacheReader> file = std::make_shared<MeshCacheReader>();
+    const MeshCacheReader& reader = *file;
+
+    if (!file->open(path))
+        return false;
+
+    size_t index = 0;
+
+    // meshes count, corners per face and flags
+    std::vector<uint32_t> header;
+    if (!reader.read(index++, header) || header.size() != 3 || header[1] != sizeof(glm::uvec3) / sizeof(uint32_t))
+        return false;
+
+    if (parents && parents->size() != header[0])
+        return false;
+
+    const bool hasTextures = (header[2] & MESH_FILE_TEXTURES) != 0;
+    const bool hasTopology = (header[2] & MESH_FILE_TOPOLOGY) != 0;
+
+    std::list<Mesh> loaded(header[0]);
+    std::list<Mesh>::const_iterator parent = parents ? parents->begin() : std::list<Mesh>::const_iterator();
+
+    size_t i = 0;
+    for (Mesh& mesh : loaded)
+    {
+        // the arrays are used where they are, in the mapping, until restoreCpuData makes them
+        mesh.File.Reader = file;
+        mesh.File.Vertices = reader.getArray<Vertex>(index++, mesh.VerticesCount);
+
+        if (!mesh.File.Vertices)
+            return false;
+
+        if (streamedTriangles.empty())
+        {
+            mesh.File.Triangles = reader.getArray<glm::uvec3>(index++, mesh.TrianglesCount);
+
+            if (!mesh.File.Triangles)
+                return false;
+        }
+        else
+        {
+            // the buffer was sized from the parent, a file that disagrees with it isn't trusted
+            size_t count = 0;
+            const glm::uvec3* faces = reader.getArray<glm::uvec3>(index++, count);
+
+            if (!faces || count != 4 * getFacesCount(*parent))
+                return false;
+
+            std::copy(faces, faces + count, streamedTriangles[i]);
+        }
+
+        if (hasTextures)
+        {
+            std::vector<uint32_t> types;
+            std::vector<char> paths;
+
+            if (!reader.read(index++, types) || !reader.read(index++, paths))
+                return false;
+
+            auto begin = paths.begin();
+            for (uint32_t type : types)
+            {
+                auto end = std::find(begin, paths.end(), '\0');
+                if (end == paths.end())
+                    return false;
+
+                Texture texture;
+                texture.Id = 0;
+                texture.Type = static_cast<aiTextureType>(type);
+                texture.Path.assign(begin, end);
+                mesh.Textures.push_back(texture);
+
+                begin = end + 1;
+            }
+        }
+
+        // a level shares the textures of the mesh it's refined from
+        if (parents)
+            mesh.Textures = parent->Textures;
+
+        // only checked here, the arrays are read with the others
+        if (hasTopology)
+        {
+            mesh.File.Topology = index;
+
+            bool isValid = true;
+            decltype(mesh.Topology)().forEachArray([&reader, &index, &isValid](auto& array)
+            {
+                size_t count = 0;
+                isValid = isValid && reader.getArray<typename std::decay_t<decltype(array)>::value_type>(index++, count);
+            });
+
+            if (!isValid)
+                return false;
+        }
+
+        if (parents)
+            ++parent;
+
+        ++i;
+    }
+
+    meshes = std::move(loaded);
+    return true;
+}
+
+bool MeshModel::writeMeshes(const std::string& path, std::list<Mesh>& meshes, bool withTextures)
+{
+    // the writer only points at the arrays, everything made here lives until the file is saved
+    std::vector<uint32_t> header { static_cast<uint32_t>(meshes.size()),
+                                   static_cast<uint32_t>(sizeof(glm::uvec3) / sizeof(uint32_t)),
+                                   MESH_FILE_TOPOLOGY | (withTextures ? MESH_FILE_TEXTURES : 0u) };
+    std::list<std::vector<uint32_t>> types;
+    std::list<std::vector<char>> paths;
+
+    MeshCacheWriter writer;
+    writer.add(header);
+
+    for (Mesh& mesh : meshes)
+    {
+        if (mesh.Topology.VertexPoints.size() != mesh.Vertices.size())
+            mesh.Topology.build(mesh.Vertices, mesh.Triangles);
+
+        writer.add(mesh.Vertices);
+        writer.add(mesh.Triangles);
+
+        if (withTextures)
+        {
+            types.emplace_back();
+            paths.emplace_back();
+
+            for (const Texture& texture : mesh.Textures)
+            {
+                types.back().push_back(static_cast<uint32_t>(texture.Type));
+                paths.back().insert(paths.back().end(), texture.Path.begin(), texture.Path.end());
+                paths.back().push_back('\0');
+            }
+
+            writer.add(types.back());
+            writer.add(paths.back());
+        }
+
+        mesh.Topology.forEachArray([&writer](auto& array) { writer.add(array); });
+    }
+
+    return writer.save(path);
+}
+
+void MeshModel::benchmarkSubdivision(unsigned level, SubdivisionStats& stats)
+{
+    level = std::min(level, MAX_SUBDIVISION_LEVEL);
+
+    for (Mesh& mesh : m_meshes)
+    {
+        // only the level being refined and its parent are alive
+        Mesh levels[2];
+        Mesh* parent = &mesh;
+
+        for (unsigned i = 0; i < level; ++i)
+        {
+            Mesh& refined = levels[i % 2];
+            refined = Mesh();
+
+            applySubdivision(*parent, refined, nullptr, nullptr, &stats);
+
+            stats.FacesCount += refined.Triangles.size();
+            parent = &refined;
+        }
+
+        stats.VerticesCount += parent->Vertices.size();
+    }
+}
+
+const char* MeshModel::getSchemeName()
+{
+    return SUBDIVISION_SCHEME;
+}
+
+void MeshModel::addMesh(std::vector<Vertex> vertices, std::vector<Mesh::Face> faces)
+{
+    Mesh mesh;
+    mesh.Vertices = std::move(vertices);
+    mesh.Triangles = std::move(faces);
+    m_meshes.emplace_back(std::move(mesh));
+}
+
+void MeshModel::updateBounds(Mesh& mesh, const Vertex* vertices)
+{
+    mesh.BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+    mesh.BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+
+    for (size_t i = 0; i < mesh.VerticesCount; ++i)
+    {
+        mesh.BoundsMin = glm::min(mesh.BoundsMin, vertices[i].Position);
+        mesh.BoundsMax = glm::max(mesh.BoundsMax, vertices[i].Position);
+    }
+}
+
+void MeshModel::restoreCpuData(Mesh& mesh)
+{
+    if (!mesh.File.Reader)
+        return;
+
+    if (mesh.Vertices.empty() && mesh.File.Vertices)
+        mesh.Vertices.assign(mesh.File.Vertices, mesh.File.Vertices + mesh.VerticesCount);
+
+    if (mesh.Triangles.empty() && mesh.File.Triangles)
+        mesh.Triangles.assign(mesh.File.Triangles, mesh.File.Triangles + mesh.TrianglesCount);
+
+    if (mesh.File.Topology && mesh.Topology.VertexPoints.empty())
+    {
+        // every array was checked when the file was opened
+        size_t index = mesh.File.Topology;
+        const MeshCacheReader& reader = *mesh.File.Reader;
+        mesh.Topology.forEachArray([&reader, &index](auto& array) { reader.read(index++, array); });
+    }
+
+    mesh.File = MeshFileArrays();
+}
+
+// Checks all material textures of a given type and loads the textures if they're not loaded yet.
+// the required info is returned as a Texture struct.
+std::list<Texture> MeshModel::loadMaterialTextures(aiMaterial* material, aiTextureType type)
+{
+    std::list<Texture> textures;
+    for (unsigned int i = 0; i < material->GetTextureCount(type); ++i)
+    {
+        aiString texturePath;
+        material->GetTexture(type, i, &texturePath);
+
+        std::string path = getFileName(texturePath.C_Str());
+
+        Texture texture;
+        texture.Id = 0;
+        texture.Type = type;
+        texture.Path = path;
+        textures.push_back(texture);
+    }
+    return textures;
+}
+
+void MeshModel::applySubdivision(Mesh& oldMesh, Mesh& newMesh, JobProgress* progress, glm::uvec3* streamedTriangles, SubdivisionStats* stats)
+{
+    if (progress && progress->isCancelled())
+        return;
+
+    // each lap is charged to the stage that just ended
+    std::chrono::steady_clock::time_point lapStart = std::chrono::steady_clock::now();
+
+    auto lap = [&lapStart, stats](double SubdivisionStats::* stage)
+    {
+        if (!stats)
+            return;
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        stats->*stage += std::chrono::duration<double>(now - lapStart).count();
+        lapStart = now;
+    };
+
+    // a mesh mapped from its file is copied out of it first, the copy is charged to the topology
+    restoreCpuData(oldMesh);
+
+    // the topology is built once per level and kept with the mesh for refining further
+    if (oldMesh.Topology.VertexPoints.size() != oldMesh.Vertices.size())
+        oldMesh.Topology.build(oldMesh.Vertices, oldMesh.Triangles);
+
+    lap(&SubdivisionStats::TopologySeconds);
+
+    const EdgeTopology& topology = oldMesh.Topology;
+    const uint32_t INVALID_INDEX = EdgeTopology::INVALID_INDEX;
+
+    const uint32_t trianglesCount = topology.getTrianglesCount();
+    const uint32_t edgesCount     = topology.getEdgesCount();
+
+    auto pointVertex = [&topology](uint32_t point) { return topology.PointVertices[point]; };
+
+    // odd vertex: 3/8 of both ends plus 1/8 of both opposite points, boundary edges stay at their midpoint
+    auto pushEdge = [this, &topology, &pointVertex](StencilTable& table, uint32_t edge)
+    {
+        const glm::uvec2& ends = topology.Edges[edge];
+        const glm::uvec2& opposites = topology.EdgeOpposites[edge];
+
+        if (topology.isBoundary(edge))
+        {
+            table.push(pointVertex(ends.x), 0.5f);
+            table.push(pointVertex(ends.y), 0.5f);
+            return;
+        }
+
+        table.push(pointVertex(ends.x), THREE_EIGHT);
+        table.push(pointVertex(ends.y), THREE_EIGHT);
+        table.push(pointVertex(opposites.x), ONE_EIGHT);
+        table.push(pointVertex(opposites.y), ONE_EIGHT);
+    };
+
+    // even vertex: (1 - n * beta) * P + beta * sum of the one-ring, (6P + left + right) / 8 along the boundary
+    auto pushPoint = [this, &topology, &pointVertex](StencilTable& table, uint32_t point)
+    {
+        uint32_t begin = topology.RingOffsets[point];
+        uint32_t end = topology.RingOffsets[point + 1];
+
+        uint32_t boundaryCount = 0;
+        for (uint32_t i = begin; i < end; ++i)
+            boundaryCount += topology.isBoundary(topology.RingEdges[i]) ? 1 : 0;
+
+        if (boundaryCount == 0 && begin != end)
+        {
+            size_t n = end - begin;
+            float beta = calculateBeta(n);
+
+            table.push(pointVertex(point), 1.0f - n * beta);
+
+            for (uint32_t i = begin; i < end; ++i)
+                table.push(pointVertex(topology.Rings[i]), beta);
+        }
+        else if (boundaryCount == 2)
+        {
+            table.push(pointVertex(point), 0.75f);
+
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (topology.isBoundary(topology.RingEdges[i]))
+                    table.push(pointVertex(topology.Rings[i]), ONE_EIGHT);
+            }
+        }
+        else
+            table.push(pointVertex(point), 1.0f);
+    };
+
+    // every triangle is split into four, texture coordinates are interpolated inside the parent triangle.
+    // child vertices are keyed by what they were made from: one per parent vertex and one per edge,
+    // unless the triangles on both sides disagree on its texture coordinate (a seam).
+    // A child vertex belongs to the first triangle side (3 * t + i) that makes it, so chunks of triangles are refined
+    // in parallel and numbered by a prefix sum of their own vertices, giving the same result for any number of threads
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    const uint32_t sidesCount = 3 * trianglesCount;
+    const uint32_t chunksCount = (trianglesCount + TRIANGLES_GRAIN - 1) / TRIANGLES_GRAIN;
+
+    std::vector<std::atomic<uint32_t>> cornerOwners(oldMesh.Vertices.size());
+    std::vector<std::atomic<uint32_t>> edgeOwners(edgesCount);
+
+    pool.parallelFor(static_cast<uint32_t>(cornerOwners.size()), 3 * TRIANGLES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t v = begin; v < end; ++v)
+            cornerOwners[v].store(INVALID_INDEX, std::memory_order_relaxed);
+    });
+
+    pool.parallelFor(edgesCount, 3 * TRIANGLES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t e = begin; e < end; ++e)
+            edgeOwners[e].store(INVALID_INDEX, std::memory_order_relaxed);
+    });
+
+    pool.parallelFor(sidesCount, 3 * TRIANGLES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t side = begin; side < end; ++side)
+        {
+            atomicMin(cornerOwners[oldMesh.Triangles[side / 3][side % 3]], side);
+            atomicMin(edgeOwners[topology.TriangleEdges[side / 3][side % 3]], side);
+        }
+    });
+
+    lap(&SubdivisionStats::DedupeSeconds);
+
+    auto sideTexCoord = [&oldMesh](uint32_t side)
+    {
+        const glm::uvec3& triangle = oldMesh.Triangles[side / 3];
+        return 0.5f * (oldMesh.Vertices[triangle[side % 3]].TexCoord + oldMesh.Vertices[triangle[(side + 1) % 3]].TexCoord);
+    };
+
+    // per triangle: bits 0-2 mark the corners it makes a vertex for, bits 4-6 the edges
+    std::vector<uint8_t> ownedMasks(trianglesCount);
+    std::vector<uint32_t> chunkBases(chunksCount + 1, 0);
+    std::vector<StencilTable> positionParts(chunksCount);
+    std::vector<StencilTable> texCoordParts(chunksCount);
+
+    pool.parallelFor(trianglesCount, TRIANGLES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        // cancelled chunks are skipped, the caller drops the whole result
+        if (progress && progress->isCancelled())
+            return;
+
+        uint32_t chunk = begin / TRIANGLES_GRAIN;
+        uint32_t ownedCount = 0;
+
+        // positions are weighted over one vertex per welded point, texture coordinates over the triangle corners
+        StencilTable& stencils = positionParts[chunk];
+        StencilTable& texCoordStencils = texCoordParts[chunk];
+
+        stencils.reserve(2 * (end - begin), 12 * static_cast<size_t>(end - begin));
+        texCoordStencils.reserve(2 * (end - begin), 4 * static_cast<size_t>(end - begin));
+
+        for (uint32_t t = begin; t < end; ++t)
+        {
+            const glm::uvec3& triangle = oldMesh.Triangles[t];
+            uint8_t mask = 0;
+
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                uint32_t side = 3 * t + i;
+
+                if (cornerOwners[triangle[i]].load(std::memory_order_relaxed) == side)
+                {
+                    mask |= 1 << i;
+                    ++ownedCount;
+
+                    pushPoint(stencils, topology.VertexPoints[triangle[i]]);
+                    stencils.close();
+
+                    texCoordStencils.push(triangle[i], 1.0f);
+                    texCoordStencils.close();
+                }
+
+                uint32_t edge = topology.TriangleEdges[t][i];
+                uint32_t first = edgeOwners[edge].load(std::memory_order_relaxed);
+
+                if (first == side || sideTexCoord(first) != sideTexCoord(side))
+                {
+                    mask |= 0x10 << i;
+                    ++ownedCount;
+
+                    pushEdge(stencils, edge);
+                    stencils.close();
+
+                    texCoordStencils.push(triangle[i], 0.5f);
+                    texCoordStencils.push(triangle[(i + 1) % 3], 0.5f);
+                    texCoordStencils.close();
+                }
+            }
+
+            ownedMasks[t] = mask;
+        }
+
+        chunkBases[chunk + 1] = ownedCount;
+
+        if (progress)
+            progress->advance(end - begin);
+    });
+
+    if (progress && progress->isCancelled())
+        return;
+
+    lap(&SubdivisionStats::RefineSeconds);
+
+    for (uint32_t c = 0; c < chunksCount; ++c)
+        chunkBases[c + 1] += chunkBases[c];
+
+    std::vector<uint32_t> cornerSlots(oldMesh.Vertices.size(), INVALID_INDEX);
+    std::vector<uint32_t> sideSlots(sidesCount, INVALID_INDEX);
+
+    pool.parallelFor(trianglesCount, TRIANGLES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        uint32_t slot = chunkBases[begin / TRIANGLES_GRAIN];
+
+        for (uint32_t t = begin; t < end; ++t)
+        {
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                if (ownedMasks[t] & (1 << i))
+                    cornerSlots[oldMesh.Triangles[t][i]] = slot++;
+
+                if (ownedMasks[t] & (0x10 << i))
+                    sideSlots[3 * t + i] = slot++;
+            }
+        }
+    });
+
+    lap(&SubdivisionStats::DedupeSeconds);
+
+    glm::uvec3* triangles = streamedTriangles;
+
+    if (!triangles)
+    {
+        newMesh.Triangles.resize(4 * static_cast<size_t>(trianglesCount));
+        triangles = newMesh.Triangles.data();
+    }
+
+    pool.parallelFor(trianglesCount, TRIANGLES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t t = begin; t < end; ++t)
+        {
+            const glm::uvec3& triangle = oldMesh.Triangles[t];
+
+            uint32_t corners[3];
+            uint32_t edges[3];
+
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                uint32_t side = 3 * t + i;
+
+                corners[i] = cornerSlots[triangle[i]];
+                edges[i] = ownedMasks[t] & (0x10 << i) ? sideSlots[side] : sideSlots[edgeOwners[topology.TriangleEdges[t][i]].load(std::memory_order_relaxed)];
+            }
+
+            triangles[4 * t + 0] = glm::uvec3(edges[0], edges[1], edges[2]);
+            triangles[4 * t + 1] = glm::uvec3(edges[2], corners[0], edges[0]);
+            triangles[4 * t + 2] = glm::uvec3(edges[0], corners[1], edges[1]);
+            triangles[4 * t + 3] = glm::uvec3(edges[1], corners[2], edges[2]);
+        }
+    });
+
+    newMesh.Stencils = concatenateStencils(positionParts);
+    StencilTable texCoordStencils = concatenateStencils(texCoordParts);
+
+    lap(&SubdivisionStats::RefineSeconds);
+
+    // a streamed level is evaluated by a second job, right into its vertex buffer once collectSubdivision mapped it
+    if (streamedTriangles)
+    {
+        newMesh.TexCoordStencils = std::move(texCoordStencils);
+        return;
+    }
+
+    newMesh.Vertices.resize(newMesh.Stencils.getStencilsCount());
+    evaluateVertices(newMesh.Stencils, texCoordStencils, oldMesh.Vertices, newMesh.Vertices.data(), newMesh.BoundsMin, newMesh.BoundsMax);
+
+    lap(&SubdivisionStats::EvaluateSeconds);
+}
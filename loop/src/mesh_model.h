@@ -0,0 +1,161 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_MESH_MODEL_H_
+#define CATMULL_CLARK_SUBDIVITION_MESH_MODEL_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <assimp/material.h>
+
+#include <glm/glm.hpp>
+
+#include "job_progress.h"
+#include "mesh_cache.h"
+#include "stencil_table.h"
+#include "subdivision_stats.h"
+#include "topology.h"
+#include "vertex.h"
+
+struct aiNode;
+struct aiMesh;
+struct aiScene;
+
+namespace CatmullClarkSubdivision
+{
+    struct ObjMaterial;
+    struct ObjMesh;
+
+    struct Texture
+    {
+        unsigned      Id;
+        aiTextureType Type;
+        std::string   Path;
+    };
+
+    // arrays of a mesh read from a binary mesh file, inside its mapping. Every mesh of the file shares the reader,
+    // the file is closed once none of them points into it any more
+    struct MeshFileArrays
+    {
+        std::shared_ptr<const MeshCacheReader> Reader;
+        const Vertex*     Vertices  = nullptr;
+        const glm::uvec3* Triangles = nullptr; // null for a streamed level, its faces went to the index buffer
+        size_t            Topology  = 0; // index of the first topology array, 0 when the file has none
+    };
+
+    struct Mesh
+    {
+        typedef glm::uvec3 Face;
+
+        std::vector<Vertex>     Vertices;
+        std::vector<glm::uvec3> Triangles;
+        std::list<Texture>      Textures;
+        EdgeTopology            Topology;
+        StencilTable            Stencils;     // positions over the vertices of the previous level
+        StencilTable            CageStencils; // positions over the original vertices, composed on first deformation
+        StencilTable            TexCoordStencils; // texture coordinates over the previous level, only while a streamed level waits
+        MeshFileArrays          File; // while the arrays above are still empty and only in the mesh file
+
+        // GL names, only a drawn Model creates them
+        unsigned VAO = 0;
+        unsigned VBO = 0;
+        unsigned EBO = 0;
+
+        // taken from the mesh file or measured on upload, still valid after the arrays are released
+        size_t    VerticesCount  = 0;
+        size_t    TrianglesCount = 0;
+        glm::vec3 BoundsMin      = glm::vec3(0.0f);
+        glm::vec3 BoundsMax      = glm::vec3(0.0f);
+    };
+
+    // the meshes of a model and everything done to them without a GL context: import, conversion, the mesh cache
+    // and refinement. Model draws them, the headless executable builds this alone
+    class MeshModel
+    {
+    public:
+        MeshModel() { }
+        virtual ~MeshModel() { }
+
+        MeshModel(const MeshModel& other)            = delete;
+        MeshModel(MeshModel&& other)                 = delete;
+        MeshModel& operator=(const MeshModel& other) = delete;
+        MeshModel& operator=(MeshModel&& other)      = delete;
+
+        static const unsigned MAX_SUBDIVISION_LEVEL = 5;
+
+        // fine on any thread: assimp import and mesh extraction. Binary mesh files are mapped and taken as they are
+        void importModel(const char* path);
+        // writes the original meshes as a binary mesh file, with their topology and textures
+        virtual void exportModel(const char* path);
+
+        // refines every original mesh up to the level without GL, the cache or the job, one mesh at a time so each
+        // stage is timed over the whole pool. Only the stats are kept
+        void benchmarkSubdivision(unsigned level, SubdivisionStats& stats);
+
+        // part of the cache file names and of benchmark reports
+        static const char* getSchemeName();
+
+        // appends an original mesh built in code instead of imported, before anything is refined or uploaded
+        void addMesh(std::vector<Vertex> vertices, std::vector<Mesh::Face> faces);
+
+        // the imported meshes and every refined level are kept in this directory between runs, a warm start maps
+        // them instead of importing and refining again. Empty (the default) disables it, must be set before importModel
+        void setCacheDirectory(const std::string& directory) { m_cacheDirectory = directory; }
+
+    protected:
+        // stops early when the progress is cancelled, leaving newMesh incomplete
+        // with streamedTriangles the triangles are written there and the vertices are left for evaluateStreamedLevel.
+        // Stats, when given, get the wall time of each stage added
+        void applySubdivision(Mesh& oldMesh, Mesh& newMesh, JobProgress* progress = nullptr, glm::uvec3* streamedTriangles = nullptr, SubdivisionStats* stats = nullptr);
+        // over the first VerticesCount vertices, wherever they are
+        static void updateBounds(Mesh& mesh, const Vertex* vertices);
+        // whether the faces are in their array, in the mesh file or only in the index buffer
+        static size_t getFacesCount(const Mesh& mesh) { return mesh.Triangles.empty() ? mesh.TrianglesCount : mesh.Triangles.size(); }
+        // copies the arrays of a mesh still mapped from its file out of it, and lets the file go.
+        // GL-free, Model reads what is still missing back from its buffers
+        static void restoreCpuData(Mesh& mesh);
+
+        bool isCacheEnabled() const { return !m_cacheDirectory.empty() && m_isSourceHashed; }
+        // false when the cache has no valid file for the level
+        bool loadLevel(unsigned level, std::list<Mesh>& meshes, const std::list<Mesh>* parents, const std::vector<glm::uvec3*>& streamedTriangles);
+        void saveLevel(unsigned level, std::list<Mesh>& meshes);
+        // builds the topology of meshes that have none yet, the next level needs it anyway
+        bool writeMeshes(const std::string& path, std::list<Mesh>& meshes, bool withTextures);
+
+        static const uint32_t TRIANGLES_GRAIN = 4096; // triangles refined by one task
+
+        const float THREE_EIGHT = 3.0f / 8.0f;
+        const float ONE_EIGHT = 1.0f / 8.0f;
+        inline float calculateBeta(size_t n) { return 3.0f / ( 8.0f * n ); }
+
+        std::list<Mesh> m_meshes;
+
+        std::string m_modelDir = "";
+
+    private:
+        // assimp side of importModel, fills the original meshes
+        void importScene(const char* path);
+        // same for OBJ files without going through assimp, false for other formats or files the reader rejects
+        bool importObj(const char* path);
+        void processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& meshes);
+        void processMesh(aiMesh* mesh, Mesh& newMesh);
+        void processMesh(ObjMesh& mesh, Mesh& newMesh);
+        std::list<Texture> processMaterial(aiMaterial* material);
+        std::list<Texture> processMaterial(const ObjMaterial& material);
+
+        std::list<Texture> loadMaterialTextures(aiMaterial* material, aiTextureType type);
+
+        // false when the file is missing or isn't a valid mesh file of this scheme. Parents are the meshes a level is
+        // refined from and give it their textures, null for original meshes. With streamedTriangles the faces are copied
+        // from the file straight into them
+        bool readMeshes(const std::string& path, std::list<Mesh>& meshes, const std::list<Mesh>* parents, const std::vector<glm::uvec3*>& streamedTriangles);
+
+        std::string m_cacheDirectory = "";
+        uint64_t m_sourceHash = 0; // of the imported file, names its cache files
+        bool m_isSourceHashed = false;
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_MESH_MODEL_H_
@@ -0,0 +1,103 @@
+#include "topology.h"
+
+#include <unordered_map>
+
+#include "vertex_welder.h"
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    uint64_t edgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+}
+
+const uint32_t EdgeTopology::INVALID_INDEX;
+
+void EdgeTopology::build(const std::vector<Vertex>& vertices, const std::vector<glm::uvec3>& triangles, float weldTolerance)
+{
+    VertexPoints.assign(vertices.size(), INVALID_INDEX);
+    PointVertices.clear();
+    PointVertices.reserve(vertices.size());
+
+    VertexWelder welder(weldTolerance);
+    welder.reserve(vertices.size());
+
+    for (uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        VertexPoints[i] = welder.weld(vertices[i].Position);
+
+        if (VertexPoints[i] == PointVertices.size())
+            PointVertices.push_back(i);
+    }
+
+    Edges.clear();
+    EdgeOpposites.clear();
+    Edges.reserve(3 * triangles.size() / 2 + 1);
+    EdgeOpposites.reserve(3 * triangles.size() / 2 + 1);
+    TriangleEdges.resize(triangles.size());
+
+    std::unordered_map<uint64_t, uint32_t> edges;
+    edges.reserve(3 * triangles.size() / 2 + 1);
+
+    for (uint32_t t = 0; t < triangles.size(); ++t)
+    {
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            uint32_t a = VertexPoints[triangles[t][i]];
+            uint32_t b = VertexPoints[triangles[t][(i + 1) % 3]];
+            uint32_t opposite = VertexPoints[triangles[t][(i + 2) % 3]];
+
+            auto inserted = edges.emplace(edgeKey(a, b), static_cast<uint32_t>(Edges.size()));
+            uint32_t edge = inserted.first->second;
+
+            if (!inserted.second && EdgeOpposites[edge].y != INVALID_INDEX)
+            {
+                // non-manifold edge: every extra triangle gets its own boundary edge
+                edge = static_cast<uint32_t>(Edges.size());
+                inserted.second = true;
+            }
+
+            if (inserted.second)
+            {
+                Edges.emplace_back(glm::uvec2(glm::min(a, b), glm::max(a, b)));
+                EdgeOpposites.emplace_back(glm::uvec2(opposite, INVALID_INDEX));
+            }
+            else
+                EdgeOpposites[edge].y = opposite;
+
+            TriangleEdges[t][i] = edge;
+        }
+    }
+
+    // one-ring adjacency in CSR form: count valences, prefix sum, then scatter both ends of every edge
+    const uint32_t pointsCount = getPointsCount();
+
+    RingOffsets.assign(pointsCount + 1, 0);
+
+    for (const glm::uvec2& edge : Edges)
+    {
+        ++RingOffsets[edge.x + 1];
+        ++RingOffsets[edge.y + 1];
+    }
+
+    for (uint32_t p = 0; p < pointsCount; ++p)
+        RingOffsets[p + 1] += RingOffsets[p];
+
+    Rings.resize(RingOffsets[pointsCount]);
+    RingEdges.resize(RingOffsets[pointsCount]);
+    std::vector<uint32_t> cursor(RingOffsets.begin(), RingOffsets.end() - 1);
+
+    for (uint32_t e = 0; e < Edges.size(); ++e)
+    {
+        const glm::uvec2& edge = Edges[e];
+
+        RingEdges[cursor[edge.x]] = e;
+        Rings[cursor[edge.x]++] = edge.y;
+
+        RingEdges[cursor[edge.y]] = e;
+        Rings[cursor[edge.y]++] = edge.x;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_TOPOLOGY_H_
+#define CATMULL_CLARK_SUBDIVITION_TOPOLOGY_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vertex.h"
+
+namespace CatmullClarkSubdivision
+{
+    // Edge table and one-ring adjacency of a triangle mesh. Vertices that share a position (e.g. split along
+    // a texture seam) are welded into one point, so smoothing sees one continuous surface while every
+    // triangle corner still references its own textured vertex.
+    struct EdgeTopology
+    {
+        static const uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+        // positions closer than weldTolerance are welded into one point, zero welds bit-identical positions only
+        void build(const std::vector<Vertex>& vertices, const std::vector<glm::uvec3>& triangles, float weldTolerance = 0.0f);
+
+        uint32_t getTrianglesCount() const { return static_cast<uint32_t>(TriangleEdges.size()); }
+        uint32_t getEdgesCount() const     { return static_cast<uint32_t>(Edges.size()); }
+        uint32_t getPointsCount() const    { return static_cast<uint32_t>(PointVertices.size()); }
+
+        bool isBoundary(uint32_t edge) const { return EdgeOpposites[edge].y == INVALID_INDEX; }
+
+        // calls visitor on every array below in a fixed order, the mesh cache stores them that way
+        template <typename Visitor>
+        void forEachArray(Visitor visitor)
+        {
+            visitor(VertexPoints);
+            visitor(PointVertices);
+            visitor(Edges);
+            visitor(EdgeOpposites);
+            visitor(TriangleEdges);
+            visitor(RingOffsets);
+            visitor(Rings);
+            visitor(RingEdges);
+        }
+
+        std::vector<uint32_t> VertexPoints;    // mesh vertex -> welded point
+        std::vector<uint32_t> PointVertices;   // welded point -> first mesh vertex with that position
+
+        std::vector<glm::uvec2> Edges;         // edge -> (min, max) welded points
+        std::vector<glm::uvec2> EdgeOpposites; // edge -> point opposite to it in each adjacent triangle
+        std::vector<glm::uvec3> TriangleEdges; // triangle -> edges (x, y), (y, z), (z, x)
+
+        // one-ring of point p is Rings[RingOffsets[p] .. RingOffsets[p + 1]), RingEdges holds the edge to each of them
+        std::vector<uint32_t> RingOffsets;
+        std::vector<uint32_t> Rings;
+        std::vector<uint32_t> RingEdges;
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_TOPOLOGY_H_
@@ -0,0 +1,244 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#endif
+
+#include "commands.h"
+#include "mesh_cache.h"
+#include "mesh_model.h"
+#include "thread_pool.h"
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    bool isModelFile(const std::string& path)
+    {
+        std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : std::string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        return extension == ".obj" || isMeshFile(path);
+    }
+
+#ifdef _WIN32
+
+    bool isDirectory(const std::string& path)
+    {
+        DWORD attributes = GetFileAttributesA(path.c_str());
+        return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+    }
+
+    void findModels(const std::string& directory, std::vector<std::string>& paths)
+    {
+        WIN32_FIND_DATAA entry;
+        HANDLE search = FindFirstFileA((directory + "\\*").c_str(), &entry);
+        if (search == INVALID_HANDLE_VALUE)
+            return;
+
+        do
+        {
+            std::string name = entry.cFileName;
+            if (name == "." || name == "..")
+                continue;
+
+            std::string path = directory + "\\" + name;
+
+            if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                findModels(path, paths);
+            else if (isModelFile(path))
+                paths.push_back(path);
+        }
+        while (FindNextFileA(search, &entry));
+
+        FindClose(search);
+    }
+
+    uint64_t getPeakResidentBytes()
+    {
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0;
+
+        return counters.PeakWorkingSetSize;
+    }
+
+#else
+
+    bool isDirectory(const std::string& path)
+    {
+        struct stat status;
+        return stat(path.c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+    }
+
+    void findModels(const std::string& directory, std::vector<std::string>& paths)
+    {
+        DIR* search = opendir(directory.c_str());
+        if (!search)
+            return;
+
+        while (dirent* entry = readdir(search))
+        {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..")
+                continue;
+
+            std::string path = directory + "/" + name;
+
+            if (isDirectory(path))
+                findModels(path, paths);
+            else if (isModelFile(path))
+                paths.push_back(path);
+        }
+
+        closedir(search);
+    }
+
+    uint64_t getPeakResidentBytes()
+    {
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+
+        // kilobytes on Linux
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+    }
+
+#endif
+
+    std::string escapeJson(const std::string& value)
+    {
+        std::string escaped;
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+                escaped.push_back('\\');
+
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char code[8] = { 0 };
+                std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                escaped.append(code);
+            }
+            else
+                escaped.push_back(c);
+        }
+        return escaped;
+    }
+}
+
+void CatmullClarkSubdivision::runBenchmark(int argc, char* argv[], std::ostream& output)
+{
+    if (argc < 1)
+        throw std::runtime_error("Usage: --benchmark <model or directory> [--levels N] [--threads T]");
+
+    std::string path = argv[0];
+    unsigned levels = 3;
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; i += 2)
+    {
+        std::string option = argv[i];
+
+        if (i + 1 >= argc)
+            throw std::runtime_error(std::string("Missing value for ").append(option).c_str());
+
+        if (option == "--levels")
+            levels = parseCount(argv[i + 1], "--levels");
+        else if (option == "--threads")
+            threads = parseCount(argv[i + 1], "--threads", ThreadPool::MAX_THREADS_COUNT);
+        else
+            throw std::runtime_error(std::string("Unknown benchmark option: ").append(option).c_str());
+    }
+
+    levels = std::min(levels, MeshModel::MAX_SUBDIVISION_LEVEL);
+
+    std::vector<std::string> paths;
+    if (isDirectory(path))
+        findModels(path, paths);
+    else
+        paths.push_back(path);
+
+    std::sort(paths.begin(), paths.end());
+
+    if (paths.empty())
+        throw std::runtime_error(std::string("No models found in ").append(path).c_str());
+
+    ThreadPool::getInstance().resize(threads);
+
+    char number[64] = { 0 };
+    auto format = [&number](double value) { std::snprintf(number, sizeof(number), "%.6f", value); return std::string(number); };
+
+    output << "{\n"
+           << "  \"scheme\": \"" << MeshModel::getSchemeName() << "\",\n"
+           << "  \"levels\": " << levels << ",\n"
+           << "  \"threads\": " << ThreadPool::getInstance().getThreadsCount() << ",\n"
+           << "  \"models\": [";
+
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        // built aside and written whole, a model that fails leaves an error entry instead of half an object, and the
+        // rest of the directory is still measured. Models of the other scheme or with the wrong faces end up here
+        std::ostringstream entry;
+
+        try
+        {
+            MeshModel model;
+            SubdivisionStats stats;
+
+            // meshes only, textures are never decoded so neither the time nor the peak memory depends on them
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            model.importModel(paths[i].c_str());
+            double importSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            model.benchmarkSubdivision(levels, stats);
+
+            double total = stats.getTotalSeconds();
+
+            entry << "    {\n"
+                  << "      \"path\": \"" << escapeJson(paths[i]) << "\",\n"
+                  << "      \"faces\": " << stats.FacesCount << ",\n"
+                  << "      \"vertices\": " << stats.VerticesCount << ",\n"
+                  << "      \"seconds\": {\n"
+                  << "        \"import\": " << format(importSeconds) << ",\n"
+                  << "        \"topology\": " << format(stats.TopologySeconds) << ",\n"
+                  << "        \"dedupe\": " << format(stats.DedupeSeconds) << ",\n"
+                  << "        \"refine\": " << format(stats.RefineSeconds) << ",\n"
+                  << "        \"evaluate\": " << format(stats.EvaluateSeconds) << ",\n"
+                  << "        \"subdivision\": " << format(total) << "\n"
+                  << "      },\n"
+                  << "      \"faces_per_second\": " << format(total > 0.0 ? static_cast<double>(stats.FacesCount) / total : 0.0) << "\n"
+                  << "    }";
+        }
+        catch (const std::exception& ex)
+        {
+            entry.str("");
+            entry << "    {\n"
+                  << "      \"path\": \"" << escapeJson(paths[i]) << "\",\n"
+                  << "      \"error\": \"" << escapeJson(ex.what()) << "\"\n"
+                  << "    }";
+        }
+
+        output << (i ? "," : "") << "\n" << entry.str();
+    }
+
+    // of the process over every model, a peak taken per model would only repeat the largest one seen so far
+    output << "\n  ],\n"
+           << "  \"peak_rss_bytes\": " << getPeakResidentBytes() << "\n"
+           << "}\n";
+}
@@ -0,0 +1,21 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_BENCHMARK_H_
+#define CATMULL_CLARK_SUBDIVITION_BENCHMARK_H_
+
+#include <ostream>
+
+namespace CatmullClarkSubdivision
+{
+    // Headless refinement, no window or GL context is created:
+    //     --benchmark <model or directory> [--levels N] [--threads T]
+    // A directory is searched recursively for .obj and mesh files. Every model is imported and refined to the level
+    // with the scheme of this executable, the mesh cache stays off so the work is always done. Textures
+    // aren't decoded, import is the time to read the meshes.
+    // Stage wall times and faces per second of every model and the peak resident memory of the whole run are
+    // written as JSON. A model that can't be imported or refined gets an "error" with the reason instead and the
+    // others are still measured.
+    // Throws on bad arguments, arguments start after "--benchmark"
+    void runBenchmark(int argc, char* argv[], std::ostream& output);
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_BENCHMARK_H_
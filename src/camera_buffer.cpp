@@ -0,0 +1,32 @@
+#include "camera_buffer.h"
+
+#undef APIENTRY
+#include <glad/glad.h>
+
+using namespace CatmullClarkSubdivision;
+
+const unsigned CameraBuffer::BINDING;
+
+void CameraBuffer::create()
+{
+    glCreateBuffers(1, &m_id);
+    glNamedBufferData(m_id, sizeof(CameraBlock), &m_block, GL_DYNAMIC_DRAW);
+    m_isDirty = false;
+}
+
+void CameraBuffer::release()
+{
+    glDeleteBuffers(1, &m_id);
+    m_id = 0;
+}
+
+void CameraBuffer::bind()
+{
+    if (m_isDirty)
+    {
+        glNamedBufferSubData(m_id, 0, sizeof(CameraBlock), &m_block);
+        m_isDirty = false;
+    }
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, m_id);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_CAMERA_BUFFER_H_
+#define CATMULL_CLARK_SUBDIVITION_CAMERA_BUFFER_H_
+
+#include <glm/glm.hpp>
+
+namespace CatmullClarkSubdivision
+{
+    // std140 layout of the Camera block declared in shaders/vertex.vs, mat4 columns need no padding
+    struct CameraBlock
+    {
+        glm::mat4 View       = glm::mat4(1.0f);
+        glm::mat4 Projection = glm::mat4(1.0f);
+    };
+
+    // Uniform buffer with the matrices every program reads, bound once per frame instead of set per program.
+    // Changes are kept on the CPU and uploaded by the next bind
+    class CameraBuffer
+    {
+    public:
+        CameraBuffer() { }
+        ~CameraBuffer() { }
+
+        CameraBuffer(const CameraBuffer& other)            = delete;
+        CameraBuffer(CameraBuffer&& other)                 = delete;
+        CameraBuffer& operator=(const CameraBuffer& other) = delete;
+        CameraBuffer& operator=(CameraBuffer&& other)      = delete;
+
+        void create();
+        void release();
+
+        void setView(const glm::mat4& view)             { m_block.View = view; m_isDirty = true; }
+        void setProjection(const glm::mat4& projection) { m_block.Projection = projection; m_isDirty = true; }
+
+        // uploads pending changes and binds the buffer to BINDING
+        void bind();
+
+        static const unsigned BINDING = 0; // has to match binding of the Camera block
+
+    private:
+        unsigned m_id = 0;
+        CameraBlock m_block;
+        bool m_isDirty = true;
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_CAMERA_BUFFER_H_
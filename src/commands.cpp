@@ -0,0 +1,63 @@
+#include "commands.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "benchmark.h"
+#include "mesh_model.h"
+#include "microbenchmark.h"
+
+using namespace CatmullClarkSubdivision;
+
+bool CatmullClarkSubdivision::runCommand(int argc, char* argv[], std::ostream& output)
+{
+    // offline conversion of anything assimp reads into the binary mesh format of this scheme.
+    // Texture names are kept relative, the converted file goes next to the source and its textures
+    if (argc == 4 && std::string(argv[1]) == "--convert")
+    {
+        MeshModel model;
+        model.importModel(argv[2]);
+        model.exportModel(argv[3]);
+        return true;
+    }
+
+    // headless refinement for measuring, see benchmark.h
+    if (argc >= 2 && std::string(argv[1]) == "--benchmark")
+    {
+        runBenchmark(argc - 2, argv + 2, output);
+        return true;
+    }
+
+    // refinement kernels one by one on generated meshes, see microbenchmark.h
+    if (argc >= 2 && std::string(argv[1]) == "--microbenchmark")
+    {
+        runMicrobenchmark(argc - 2, argv + 2, output);
+        return true;
+    }
+
+    return false;
+}
+
+const char* CatmullClarkSubdivision::getCommandsUsage()
+{
+    return "Usage:\n"
+           "    --convert <model> <mesh file>\n"
+           "    --benchmark <model or directory> [--levels N] [--threads T]\n"
+           "    --microbenchmark [--faces N] [--iterations I] [--warmup W] [--threads T]\n";
+}
+
+unsigned CatmullClarkSubdivision::parseCount(const char* value, const char* option, unsigned maximum)
+{
+    // strtoull alone would skip spaces and wrap a minus sign around to a huge count
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long count = std::isdigit(static_cast<unsigned char>(value[0])) ? std::strtoull(value, &end, 10) : 0;
+
+    if (!end || *end != '\0' || errno == ERANGE || count > maximum)
+        throw std::runtime_error(std::string("Not a number for ").append(option).append(": ").append(value).c_str());
+
+    return static_cast<unsigned>(count);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_COMMANDS_H_
+#define CATMULL_CLARK_SUBDIVITION_COMMANDS_H_
+
+#include <climits>
+#include <ostream>
+
+namespace CatmullClarkSubdivision
+{
+    // Everything the executables do without a window, arguments as main gets them:
+    //     --convert <model> <mesh file>
+    //     --benchmark ..., see benchmark.h
+    //     --microbenchmark ..., see microbenchmark.h
+    // False when the arguments name none of them. Throws on bad arguments
+    bool runCommand(int argc, char* argv[], std::ostream& output);
+
+    // one line per command, for executables that have nothing else to run
+    const char* getCommandsUsage();
+
+    // value of a count option, only decimal digits up to maximum. Throws naming the option otherwise
+    unsigned parseCount(const char* value, const char* option, unsigned maximum = UINT_MAX);
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_COMMANDS_H_
@@ -0,0 +1,24 @@
+#include <exception>
+#include <iostream>
+
+#include "commands.h"
+
+using namespace CatmullClarkSubdivision;
+
+// console executable for machines without a display, GL or SDL. It only has the commands, see commands.h
+int main(int argc, char* argv[])
+{
+    try
+    {
+        if (runCommand(argc, argv, std::cout))
+            return 0;
+
+        std::cerr << getCommandsUsage();
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "ERROR OCCURED: " << ex.what() << std::endl;
+    }
+
+    return -1;
+}
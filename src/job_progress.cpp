@@ -0,0 +1,35 @@
+#include "job_progress.h"
+
+#include <algorithm>
+
+using namespace CatmullClarkSubdivision;
+
+void JobProgress::start(uint64_t total)
+{
+    m_done.store(0);
+    m_total.store(total);
+    m_isCancelled.store(false);
+    m_start = std::chrono::steady_clock::now();
+}
+
+float JobProgress::getFraction() const
+{
+    uint64_t total = getTotal();
+    return total ? std::min(static_cast<float>(getDone()) / static_cast<float>(total), 1.0f) : 0.0f;
+}
+
+double JobProgress::getElapsedSeconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+double JobProgress::getRemainingSeconds() const
+{
+    uint64_t done = getDone();
+    uint64_t total = getTotal();
+
+    if (done == 0)
+        return -1.0;
+
+    return done >= total ? 0.0 : getElapsedSeconds() * static_cast<double>(total - done) / static_cast<double>(done);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_JOB_PROGRESS_H_
+#define CATMULL_CLARK_SUBDIVITION_JOB_PROGRESS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace CatmullClarkSubdivision
+{
+    // Progress of a background job in arbitrary work units, shared by the job and the thread watching it.
+    // Cancelling only raises a flag, the job is expected to check it between units and stop early
+    class JobProgress
+    {
+    public:
+        JobProgress() { }
+
+        JobProgress(const JobProgress& other)            = delete;
+        JobProgress(JobProgress&& other)                 = delete;
+        JobProgress& operator=(const JobProgress& other) = delete;
+        JobProgress& operator=(JobProgress&& other)      = delete;
+
+        // resets the counters and the flag, must not be called while a job still reports to it
+        void start(uint64_t total);
+        void advance(uint64_t count) { m_done.fetch_add(count, std::memory_order_relaxed); }
+
+        void cancel() { m_isCancelled.store(true, std::memory_order_relaxed); }
+        bool isCancelled() const { return m_isCancelled.load(std::memory_order_relaxed); }
+
+        uint64_t getDone() const  { return m_done.load(std::memory_order_relaxed); }
+        uint64_t getTotal() const { return m_total.load(std::memory_order_relaxed); }
+        float getFraction() const;
+
+        double getElapsedSeconds() const;
+        // extrapolated from the rate so far, negative until there is any progress
+        double getRemainingSeconds() const;
+
+    private:
+        std::atomic<uint64_t> m_done { 0 };
+        std::atomic<uint64_t> m_total { 0 };
+        std::atomic<bool> m_isCancelled { false };
+
+        std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_JOB_PROGRESS_H_
@@ -6,6 +6,7 @@
 #include <exception>
 #include <iostream>
 
+#include "commands.h"
 #include "engine.h"
 
 using namespace CatmullClarkSubdivision;
@@ -14,6 +15,10 @@ int main(int argc, char* argv[])
 {
     try
     {
+        // conversion and benchmarks, see commands.h. No window is opened for them
+        if (runCommand(argc, argv, std::cout))
+            return 0;
+
         Engine engine;
         engine.init();
         engine.setTitle("Catmull-Clark Subdivision");
@@ -22,7 +27,7 @@ int main(int argc, char* argv[])
 
         engine.release();
     }
-    catch (std::exception ex)
+    catch (const std::exception& ex)
     {
         std::cerr << "ERROR OCCURED: " << ex.what() << std::endl;
         return -1;
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_MAPPED_FILE_H_
+#define CATMULL_CLARK_SUBDIVITION_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace CatmullClarkSubdivision
+{
+    // Read-only view of a whole file through the page cache, pages are only read when touched
+    class MappedFile
+    {
+    public:
+        MappedFile() { }
+        ~MappedFile();
+
+        MappedFile(const MappedFile& other)            = delete;
+        MappedFile(MappedFile&& other)                 = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+        MappedFile& operator=(MappedFile&& other)      = delete;
+
+        // false when the file is missing, empty or can't be mapped
+        bool open(const std::string& path);
+        void close();
+
+        bool isOpen() const { return m_data != nullptr; }
+        const unsigned char* getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+
+    private:
+        const unsigned char* m_data = nullptr;
+        size_t m_size = 0;
+
+#ifdef _WIN32
+        void* m_file    = nullptr;
+        void* m_mapping = nullptr;
+#else
+        int m_file = -1;
+#endif
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_MAPPED_FILE_H_
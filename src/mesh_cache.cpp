@@ -0,0 +1,190 @@
+#include "mesh_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    const char MAGIC[8] = { 'S', 'U', 'B', 'D', 'M', 'E', 'S', 'H' };
+    // bumped whenever the layout of the arrays changes, older files are then ignored
+    const uint32_t VERSION = 2;
+    const uint64_t ALIGNMENT = 16;
+
+    struct Header
+    {
+        char     Magic[8];
+        uint32_t Version;
+        uint32_t ArraysCount;
+    };
+
+    struct Entry
+    {
+        uint64_t Offset;
+        uint64_t Size;
+    };
+
+    uint64_t align(uint64_t offset)
+    {
+        return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+}
+
+const char* const CatmullClarkSubdivision::MESH_FILE_EXTENSION = ".smesh";
+
+bool CatmullClarkSubdivision::isMeshFile(const std::string& path)
+{
+    size_t length = std::strlen(MESH_FILE_EXTENSION);
+    return path.size() >= length && path.compare(path.size() - length, length, MESH_FILE_EXTENSION) == 0;
+}
+
+std::string CatmullClarkSubdivision::getMeshCachePath(const std::string& directory, uint64_t sourceHash, const char* scheme, unsigned level)
+{
+    char name[64] = { 0 };
+    std::snprintf(name, sizeof(name), "%016llx_%s_%u%s", static_cast<unsigned long long>(sourceHash), scheme, level, MESH_FILE_EXTENSION);
+
+    // forward slashes are fine on every platform
+    return directory + "/" + name;
+}
+
+bool CatmullClarkSubdivision::hashFile(const std::string& path, uint64_t& hash)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    hash = 14695981039346656037ull;
+
+    std::vector<char> chunk(1 << 20);
+    while (file)
+    {
+        file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+
+        std::streamsize count = file.gcount();
+        for (std::streamsize i = 0; i < count; ++i)
+        {
+            hash ^= static_cast<unsigned char>(chunk[static_cast<size_t>(i)]);
+            hash *= 1099511628211ull;
+        }
+    }
+
+    return file.eof();
+}
+
+void MeshCacheWriter::add(const void* data, size_t size)
+{
+    m_arrays.emplace_back(data, size);
+}
+
+bool MeshCacheWriter::save(const std::string& path) const
+{
+    Header header;
+    std::memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+    header.Version = VERSION;
+    header.ArraysCount = static_cast<uint32_t>(m_arrays.size());
+
+    std::vector<Entry> entries(m_arrays.size());
+
+    uint64_t offset = align(sizeof(Header) + entries.size() * sizeof(Entry));
+    for (size_t i = 0; i < m_arrays.size(); ++i)
+    {
+        entries[i].Offset = offset;
+        entries[i].Size = m_arrays[i].second;
+        offset = align(offset + entries[i].Size);
+    }
+
+    // models importing the same file on other threads write the same path
+    std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        const char padding[ALIGNMENT] = { 0 };
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+
+        uint64_t written = sizeof(Header) + entries.size() * sizeof(Entry);
+        for (size_t i = 0; i < m_arrays.size(); ++i)
+        {
+            file.write(padding, static_cast<std::streamsize>(entries[i].Offset - written));
+            file.write(static_cast<const char*>(m_arrays[i].first), static_cast<std::streamsize>(m_arrays[i].second));
+            written = entries[i].Offset + entries[i].Size;
+        }
+
+        if (!file)
+        {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    // rename doesn't replace an existing file everywhere
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool MeshCacheReader::open(const std::string& path)
+{
+    close();
+
+    if (!m_file.open(path))
+        return false;
+
+    const unsigned char* data = m_file.getData();
+    const uint64_t size = m_file.getSize();
+
+    Header header;
+    if (size < sizeof(header))
+    {
+        close();
+        return false;
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+
+    uint64_t tableEnd = sizeof(Header) + static_cast<uint64_t>(header.ArraysCount) * sizeof(Entry);
+    if (std::memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 || header.Version != VERSION || tableEnd > size)
+    {
+        close();
+        return false;
+    }
+
+    m_arrays.resize(header.ArraysCount);
+
+    for (size_t i = 0; i < m_arrays.size(); ++i)
+    {
+        Entry entry;
+        std::memcpy(&entry, data + sizeof(Header) + i * sizeof(Entry), sizeof(entry));
+
+        // a truncated or corrupted file is rejected as a whole
+        if (entry.Offset % ALIGNMENT != 0 || entry.Offset < tableEnd || entry.Offset > size || entry.Size > size - entry.Offset)
+        {
+            close();
+            return false;
+        }
+
+        m_arrays[i] = std::make_pair(entry.Offset, entry.Size);
+    }
+
+    return true;
+}
+
+void MeshCacheReader::close()
+{
+    m_file.close();
+    m_arrays.clear();
+}
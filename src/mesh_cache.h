@@ -0,0 +1,85 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_MESH_CACHE_H_
+#define CATMULL_CLARK_SUBDIVITION_MESH_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace CatmullClarkSubdivision
+{
+    // Binary mesh files, both the native model format and the cache of refined levels. A file is a table of contents
+    // followed by raw arrays, each aligned to 16 bytes so a mapped file is used in place.
+    // The first array holds the meshes count, the corners per face and the flags below, then every mesh has its
+    // vertices, its faces and whatever the flags announce, in that order
+    const uint32_t MESH_FILE_TEXTURES = 1u; // texture types and zero terminated file names, relative to the model
+    const uint32_t MESH_FILE_TOPOLOGY = 2u; // every array of the scheme's topology, so refinement doesn't build it
+
+    extern const char* const MESH_FILE_EXTENSION;
+
+    bool isMeshFile(const std::string& path);
+
+    // Cached levels are named after the hash of the source file, the scheme and the level:
+    // an edited source gets new names and its stale files are never opened again
+    std::string getMeshCachePath(const std::string& directory, uint64_t sourceHash, const char* scheme, unsigned level);
+
+    // FNV-1a of the file content, false when it can't be read
+    bool hashFile(const std::string& path, uint64_t& hash);
+
+    class MeshCacheWriter
+    {
+    public:
+        // only the pointer is kept, the array must stay alive until save
+        template <typename T>
+        void add(const std::vector<T>& array) { add(array.data(), array.size() * sizeof(T)); }
+        void add(const void* data, size_t size);
+
+        // written under a temporary name and renamed, a reader never sees half a file
+        bool save(const std::string& path) const;
+
+    private:
+        std::vector<std::pair<const void*, size_t>> m_arrays;
+    };
+
+    class MeshCacheReader
+    {
+    public:
+        // false when the file is missing or isn't a cache file of this version
+        bool open(const std::string& path);
+        void close();
+
+        size_t getArraysCount() const { return m_arrays.size(); }
+
+        // points into the mapping, valid until close. Null when the index is past the end or the size isn't a whole number of T
+        template <typename T>
+        const T* getArray(size_t index, size_t& count) const
+        {
+            if (index >= m_arrays.size() || m_arrays[index].second % sizeof(T) != 0)
+                return nullptr;
+
+            count = static_cast<size_t>(m_arrays[index].second / sizeof(T));
+            return reinterpret_cast<const T*>(m_file.getData() + m_arrays[index].first);
+        }
+
+        template <typename T>
+        bool read(size_t index, std::vector<T>& array) const
+        {
+            size_t count = 0;
+            const T* data = getArray<T>(index, count);
+            if (!data)
+                return false;
+
+            array.assign(data, data + count);
+            return true;
+        }
+
+    private:
+        MappedFile m_file;
+        std::vector<std::pair<uint64_t, uint64_t>> m_arrays; // offset, size in bytes
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_MESH_CACHE_H_
@@ -0,0 +1,221 @@
+#include "microbenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "commands.h"
+#include "mesh_model.h"
+#include "synthetic_meshes.h"
+#include "thread_pool.h"
+#include "vertex_welder.h"
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    // seconds of every timed iteration of one kernel
+    struct KernelTimes
+    {
+        const char*         Name;
+        std::vector<double> Seconds;
+    };
+
+    template <typename Function>
+    double measure(Function function)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // one level of the input refined like a streamed level, so its stencils are kept instead of evaluated, and a
+    // vertex buffer sized for it once, the way collectSubdivision maps one
+    class StreamedLevel : public MeshModel
+    {
+    public:
+        explicit StreamedLevel(const SyntheticMesh<Mesh::Face>& mesh)
+        {
+            addMesh(mesh.Vertices, mesh.Faces);
+
+            std::vector<Mesh::Face> faces(4 * getFacesCount(m_meshes.front()));
+            applySubdivision(m_meshes.front(), m_level, nullptr, faces.data());
+
+            m_vertices.resize(m_level.Stencils.getStencilsCount());
+        }
+
+        // only the upload path, evaluateVertices over the whole pool into the buffer
+        void evaluate()
+        {
+            evaluateVertices(m_level.Stencils, m_level.TexCoordStencils, m_meshes.front().Vertices, m_vertices.data(), m_level.BoundsMin, m_level.BoundsMax);
+        }
+
+    private:
+        Mesh m_level;
+        std::vector<Vertex> m_vertices;
+    };
+}
+
+void CatmullClarkSubdivision::runMicrobenchmark(int argc, char* argv[], std::ostream& output)
+{
+    unsigned facesCount = 65536;
+    unsigned iterations = 10;
+    unsigned warmup = 2;
+    unsigned threads = 0;
+
+    for (int i = 0; i < argc; i += 2)
+    {
+        std::string option = argv[i];
+
+        if (i + 1 >= argc)
+            throw std::runtime_error(std::string("Missing value for ").append(option).c_str());
+
+        if (option == "--faces")
+            facesCount = parseCount(argv[i + 1], "--faces");
+        else if (option == "--iterations")
+            iterations = parseCount(argv[i + 1], "--iterations");
+        else if (option == "--warmup")
+            warmup = parseCount(argv[i + 1], "--warmup");
+        else if (option == "--threads")
+            threads = parseCount(argv[i + 1], "--threads", ThreadPool::MAX_THREADS_COUNT);
+        else
+            throw std::runtime_error(std::string("Unknown microbenchmark option: ").append(option).c_str());
+    }
+
+    if (facesCount == 0 || iterations == 0)
+        throw std::runtime_error("Faces and iterations have to be at least one");
+
+    ThreadPool::getInstance().resize(threads);
+
+    std::vector<SyntheticMesh<Mesh::Face>> meshes;
+    makeSyntheticMeshes(facesCount, meshes);
+
+    char number[64] = { 0 };
+    auto format = [&number](double value) { std::snprintf(number, sizeof(number), "%.9f", value); return std::string(number); };
+
+    output << "{\n"
+           << "  \"scheme\": \"" << MeshModel::getSchemeName() << "\",\n"
+           << "  \"threads\": " << ThreadPool::getInstance().getThreadsCount() << ",\n"
+           << "  \"warmup\": " << warmup << ",\n"
+           << "  \"iterations\": " << iterations << ",\n"
+           << "  \"requested_faces\": " << facesCount << ",\n"
+           << "  \"inputs\": [";
+
+    for (size_t m = 0; m < meshes.size(); ++m)
+    {
+        const SyntheticMesh<Mesh::Face>& mesh = meshes[m];
+
+        KernelTimes topology = { "topology", { } };
+        KernelTimes weld     = { "weld", { } };
+        KernelTimes dedupe   = { "dedupe", { } };
+        KernelTimes refine   = { "refine", { } };
+        KernelTimes evaluate = { "evaluate", { } };
+
+        for (unsigned i = 0; i < warmup + iterations; ++i)
+        {
+            double seconds = measure([&mesh]()
+            {
+                decltype(Mesh::Topology) built;
+                built.build(mesh.Vertices, mesh.Faces);
+            });
+
+            if (i >= warmup)
+                topology.Seconds.push_back(seconds);
+        }
+
+        for (unsigned i = 0; i < warmup + iterations; ++i)
+        {
+            double seconds = measure([&mesh]()
+            {
+                VertexWelder welder;
+                welder.reserve(mesh.Vertices.size());
+
+                for (const Vertex& vertex : mesh.Vertices)
+                    welder.weld(vertex.Position);
+            });
+
+            if (i >= warmup)
+                weld.Seconds.push_back(seconds);
+        }
+
+        // one level over the whole pool, the topology of the input is built by the first run and kept.
+        // Edge, face and vertex points are made in the same pass over the faces so they are timed together
+        {
+            MeshModel model;
+            model.addMesh(mesh.Vertices, mesh.Faces);
+
+            for (unsigned i = 0; i < warmup + iterations; ++i)
+            {
+                SubdivisionStats stats;
+                model.benchmarkSubdivision(1, stats);
+
+                if (i < warmup)
+                    continue;
+
+                dedupe.Seconds.push_back(stats.DedupeSeconds);
+                refine.Seconds.push_back(stats.RefineSeconds);
+            }
+        }
+
+        // vertices laid out as they are uploaded, into a buffer that already exists. Allocating the level isn't timed
+        {
+            StreamedLevel level(mesh);
+
+            for (unsigned i = 0; i < warmup + iterations; ++i)
+            {
+                double seconds = measure([&level]() { level.evaluate(); });
+
+                if (i >= warmup)
+                    evaluate.Seconds.push_back(seconds);
+            }
+        }
+
+        output << (m ? "," : "") << "\n"
+               << "    {\n"
+               << "      \"name\": \"" << mesh.Name << "\",\n"
+               << "      \"faces\": " << mesh.Faces.size() << ",\n"
+               << "      \"vertices\": " << mesh.Vertices.size() << ",\n"
+               << "      \"kernels\": {";
+
+        KernelTimes* kernels[] = { &topology, &weld, &dedupe, &refine, &evaluate };
+
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k)
+        {
+            std::vector<double>& seconds = kernels[k]->Seconds;
+            std::sort(seconds.begin(), seconds.end());
+
+            size_t middle = seconds.size() / 2;
+            double median = seconds.size() % 2 ? seconds[middle] : 0.5 * (seconds[middle - 1] + seconds[middle]);
+
+            double mean = 0.0;
+            for (double value : seconds)
+                mean += value;
+            mean /= seconds.size();
+
+            double variance = 0.0;
+            for (double value : seconds)
+                variance += (value - mean) * (value - mean);
+            variance /= seconds.size();
+
+            output << (k ? "," : "") << "\n"
+                   << "        \"" << kernels[k]->Name << "\": {\n"
+                   << "          \"min\": " << format(seconds.front()) << ",\n"
+                   << "          \"median\": " << format(median) << ",\n"
+                   << "          \"mean\": " << format(mean) << ",\n"
+                   << "          \"stddev\": " << format(std::sqrt(variance)) << ",\n"
+                   << "          \"faces_per_second\": " << format(median > 0.0 ? static_cast<double>(mesh.Faces.size()) / median : 0.0) << "\n"
+                   << "        }";
+        }
+
+        output << "\n      }\n"
+               << "    }";
+    }
+
+    output << "\n  ]\n"
+           << "}\n";
+}
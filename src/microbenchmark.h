@@ -0,0 +1,18 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_MICROBENCHMARK_H_
+#define CATMULL_CLARK_SUBDIVITION_MICROBENCHMARK_H_
+
+#include <ostream>
+
+namespace CatmullClarkSubdivision
+{
+    // Refinement kernels timed one by one on generated meshes, no window or GL context is created:
+    //     --microbenchmark [--faces N] [--iterations I] [--warmup W] [--threads T]
+    // Every input of this scheme from synthetic_meshes.h is built with about N faces and each kernel runs W untimed
+    // and I timed times. Min, median, mean and standard deviation in seconds and faces per second of the median,
+    // over the faces the input actually has, are written as JSON. Throws on bad arguments, arguments start after
+    // "--microbenchmark"
+    void runMicrobenchmark(int argc, char* argv[], std::ostream& output);
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_MICROBENCHMARK_H_
@@ -0,0 +1,487 @@
+#include "obj_reader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    const size_t CHUNK_SIZE = 1 << 20; // bytes parsed by one task, moved forward to the next line start
+    const uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+    const int64_t NO_TEX_COORD = std::numeric_limits<int64_t>::min();
+
+    enum class EStatement
+    {
+        EObject,
+        EMaterial,
+        ELibrary
+    };
+
+    // takes effect before face Face of its chunk
+    struct Statement
+    {
+        EStatement  Kind;
+        uint32_t    Face;
+        std::string Name;
+    };
+
+    // zero based, positive indices are absolute and negative ones count back from their line
+    struct Corner
+    {
+        int64_t Position;
+        int64_t TexCoord;
+    };
+
+    struct Chunk
+    {
+        std::vector<glm::vec3> Positions;
+        std::vector<glm::vec2> TexCoords;
+        std::vector<uint32_t>  FaceSizes;
+        std::vector<Corner>    Corners;
+        // corners with relative indices, they are relative to the chunk start until merged
+        std::vector<size_t>    RelativePositions;
+        std::vector<size_t>    RelativeTexCoords;
+        std::vector<Statement> Statements;
+        bool IsValid = true;
+    };
+
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    const char* skipSpaces(const char* p, const char* end)
+    {
+        while (p < end && isSpace(*p))
+            ++p;
+        return p;
+    }
+
+    // whether the line starts with the keyword followed by a space
+    bool isKeyword(const char* p, const char* end, const char* keyword)
+    {
+        size_t length = std::strlen(keyword);
+        return static_cast<size_t>(end - p) > length && std::memcmp(p, keyword, length) == 0 && isSpace(p[length]);
+    }
+
+    std::string getRest(const char* p, const char* end)
+    {
+        p = skipSpaces(p, end);
+        while (end > p && isSpace(end[-1]))
+            --end;
+        return std::string(p, end);
+    }
+
+    // up to 19 significant digits scaled by an exact power of ten, enough for the few digits OBJ exporters write.
+    // Returns null when there is no number
+    const char* parseFloat(const char* p, const char* end, float& value)
+    {
+        static const double POWERS[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+        bool isNegative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            isNegative = *p++ == '-';
+
+        uint64_t mantissa = 0;
+        int digitsCount = 0;
+        int exponent = 0;
+        bool hasDigits = false;
+
+        for (; p < end && isDigit(*p); ++p, hasDigits = true)
+        {
+            if (digitsCount < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                digitsCount += mantissa != 0;
+            }
+            else
+                ++exponent;
+        }
+
+        if (p < end && *p == '.')
+        {
+            for (++p; p < end && isDigit(*p); ++p, hasDigits = true)
+            {
+                if (digitsCount < 19)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    digitsCount += mantissa != 0;
+                    --exponent;
+                }
+            }
+        }
+
+        if (!hasDigits)
+            return nullptr;
+
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char* q = p + 1;
+
+            bool isExponentNegative = false;
+            if (q < end && (*q == '-' || *q == '+'))
+                isExponentNegative = *q++ == '-';
+
+            int power = 0;
+            bool hasExponent = false;
+            for (; q < end && isDigit(*q); ++q, hasExponent = true)
+                power = std::min(power * 10 + (*q - '0'), 10000);
+
+            if (hasExponent)
+            {
+                exponent += isExponentNegative ? -power : power;
+                p = q;
+            }
+        }
+
+        double result = static_cast<double>(mantissa);
+
+        if (exponent < 0)
+            result = exponent >= -22 ? result / POWERS[-exponent] : result * std::pow(10.0, exponent);
+        else if (exponent > 0)
+            result = exponent <= 22 ? result * POWERS[exponent] : result * std::pow(10.0, exponent);
+
+        value = static_cast<float>(isNegative ? -result : result);
+        return p;
+    }
+
+    // zero based index, relative ones are resolved against count. Null when there is no index or it is zero
+    const char* parseIndex(const char* p, const char* end, int64_t count, int64_t& index, bool& isRelative)
+    {
+        bool isNegative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            isNegative = *p++ == '-';
+
+        int64_t value = 0;
+        const char* digits = p;
+        for (; p < end && isDigit(*p); ++p)
+            value = std::min<int64_t>(value * 10 + (*p - '0'), std::numeric_limits<uint32_t>::max());
+
+        if (p == digits || value == 0)
+            return nullptr;
+
+        isRelative = isNegative;
+        index = isNegative ? count - value : value - 1;
+        return p;
+    }
+
+    void parseFace(const char* p, const char* end, Chunk& chunk)
+    {
+        uint32_t size = 0;
+
+        for (p = skipSpaces(p, end); p < end; p = skipSpaces(p, end))
+        {
+            Corner corner { 0, NO_TEX_COORD };
+            bool isRelative = false;
+
+            p = parseIndex(p, end, static_cast<int64_t>(chunk.Positions.size()), corner.Position, isRelative);
+            if (!p)
+            {
+                chunk.IsValid = false;
+                return;
+            }
+
+            if (isRelative)
+                chunk.RelativePositions.push_back(chunk.Corners.size());
+
+            // v/vt, v/vt/vn and v//vn
+            if (p < end && *p == '/')
+            {
+                ++p;
+
+                if (p < end && *p != '/')
+                {
+                    p = parseIndex(p, end, static_cast<int64_t>(chunk.TexCoords.size()), corner.TexCoord, isRelative);
+                    if (!p)
+                    {
+                        chunk.IsValid = false;
+                        return;
+                    }
+
+                    if (isRelative)
+                        chunk.RelativeTexCoords.push_back(chunk.Corners.size());
+                }
+
+                // normals aren't kept
+                while (p < end && !isSpace(*p))
+                    ++p;
+            }
+
+            chunk.Corners.push_back(corner);
+            ++size;
+        }
+
+        chunk.FaceSizes.push_back(size);
+    }
+
+    void parseLine(const char* p, const char* end, Chunk& chunk)
+    {
+        if (p == end)
+            return;
+
+        if (isKeyword(p, end, "v"))
+        {
+            glm::vec3 position(0.0f);
+            p += 2;
+
+            for (int i = 0; i < 3 && p; ++i)
+                p = parseFloat(skipSpaces(p, end), end, position[i]);
+
+            chunk.Positions.push_back(position);
+        }
+        else if (isKeyword(p, end, "vt"))
+        {
+            glm::vec2 texCoord(0.0f);
+            p += 3;
+
+            for (int i = 0; i < 2 && p; ++i)
+                p = parseFloat(skipSpaces(p, end), end, texCoord[i]);
+
+            chunk.TexCoords.push_back(texCoord);
+        }
+        else if (isKeyword(p, end, "f"))
+            parseFace(p + 2, end, chunk);
+        else if (isKeyword(p, end, "o"))
+            chunk.Statements.push_back(Statement { EStatement::EObject, static_cast<uint32_t>(chunk.FaceSizes.size()), getRest(p + 2, end) });
+        else if (isKeyword(p, end, "usemtl"))
+            chunk.Statements.push_back(Statement { EStatement::EMaterial, static_cast<uint32_t>(chunk.FaceSizes.size()), getRest(p + 7, end) });
+        else if (isKeyword(p, end, "mtllib"))
+            chunk.Statements.push_back(Statement { EStatement::ELibrary, static_cast<uint32_t>(chunk.FaceSizes.size()), getRest(p + 7, end) });
+    }
+
+    void parseChunk(const char* p, const char* end, Chunk& chunk)
+    {
+        while (p < end)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!lineEnd)
+                lineEnd = end;
+
+            parseLine(skipSpaces(p, lineEnd), lineEnd, chunk);
+            p = lineEnd + 1;
+        }
+    }
+
+    // only the maps Model picks up, the file name is the last word of the line after any options
+    void readMaterials(const std::string& path, std::map<std::string, ObjMaterial>& materials)
+    {
+        std::ifstream file(path);
+        std::string line;
+        ObjMaterial* material = nullptr;
+
+        while (std::getline(file, line))
+        {
+            const char* begin = skipSpaces(line.data(), line.data() + line.size());
+            const char* end = line.data() + line.size();
+
+            const char* keywordEnd = begin;
+            while (keywordEnd < end && !isSpace(*keywordEnd))
+                ++keywordEnd;
+
+            std::string keyword(begin, keywordEnd);
+            std::transform(keyword.begin(), keyword.end(), keyword.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+            std::string rest = getRest(keywordEnd, end);
+
+            if (keyword == "newmtl")
+            {
+                material = &materials[rest];
+                continue;
+            }
+
+            size_t nameBegin = rest.find_last_of(" \t");
+            std::string name = nameBegin == std::string::npos ? rest : rest.substr(nameBegin + 1);
+
+            if (!material || name.empty())
+                continue;
+
+            if (keyword == "map_kd")
+                material->DiffuseMap = name;
+            else if (keyword == "map_ks")
+                material->SpecularMap = name;
+            else if (keyword == "map_bump" || keyword == "bump")
+                material->BumpMap = name;
+            else if (keyword == "map_ka")
+                material->AmbientMap = name;
+        }
+    }
+}
+
+bool CatmullClarkSubdivision::readObj(const std::string& path, std::vector<ObjMesh>& meshes)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+
+    const char* data = reinterpret_cast<const char*>(file.getData());
+    const size_t size = file.getSize();
+
+    // every chunk starts right after a line break, so no line is split between two of them
+    std::vector<size_t> starts;
+    for (size_t start = 0; start < size; start += CHUNK_SIZE)
+    {
+        while (start > 0 && start < size && data[start - 1] != '\n')
+            ++start;
+
+        if (start < size && (starts.empty() || starts.back() < start))
+            starts.push_back(start);
+    }
+
+    starts.push_back(size);
+
+    std::vector<Chunk> chunks(starts.size() - 1);
+
+    ThreadPool::getInstance().parallelFor(static_cast<uint32_t>(chunks.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            parseChunk(data + starts[i], data + starts[i + 1], chunks[i]);
+    });
+
+    // chunks are concatenated in file order, relative indices only need the counts of the chunks before
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+
+    for (Chunk& chunk : chunks)
+    {
+        if (!chunk.IsValid)
+            return false;
+
+        for (size_t corner : chunk.RelativePositions)
+            chunk.Corners[corner].Position += static_cast<int64_t>(positions.size());
+
+        for (size_t corner : chunk.RelativeTexCoords)
+            chunk.Corners[corner].TexCoord += static_cast<int64_t>(texCoords.size());
+
+        positions.insert(positions.end(), chunk.Positions.begin(), chunk.Positions.end());
+        texCoords.insert(texCoords.end(), chunk.TexCoords.begin(), chunk.TexCoords.end());
+
+        std::vector<glm::vec3>().swap(chunk.Positions);
+        std::vector<glm::vec2>().swap(chunk.TexCoords);
+    }
+
+    // material libraries are named relative to the model
+    std::string directory;
+    if (path.find_last_of("/\\") != std::string::npos)
+        directory = path.substr(0, path.find_last_of("/\\") + 1);
+
+    std::map<std::string, ObjMaterial> materials;
+    for (const Chunk& chunk : chunks)
+    {
+        for (const Statement& statement : chunk.Statements)
+        {
+            if (statement.Kind == EStatement::ELibrary)
+                readMaterials(directory + statement.Name, materials);
+        }
+    }
+
+    // corners are welded per mesh on their position and texture coordinate indices, heads[position] starts the list
+    // of vertices using that position. Only the heads touched by a mesh are reset for the next one
+    std::vector<uint32_t> heads(positions.size(), INVALID_INDEX);
+    std::vector<uint32_t> nexts;
+    std::vector<uint32_t> vertexPositions;
+    std::vector<int64_t>  vertexTexCoords;
+
+    std::vector<ObjMesh> result;
+    std::string material;
+    bool isMeshOpen = false;
+
+    auto apply = [&](const Statement& statement)
+    {
+        if (statement.Kind == EStatement::EObject || (statement.Kind == EStatement::EMaterial && statement.Name != material))
+            isMeshOpen = false;
+
+        if (statement.Kind == EStatement::EMaterial)
+            material = statement.Name;
+    };
+
+    for (const Chunk& chunk : chunks)
+    {
+        size_t corner = 0;
+        size_t statement = 0;
+
+        for (uint32_t face = 0; face < chunk.FaceSizes.size(); ++face)
+        {
+            for (; statement < chunk.Statements.size() && chunk.Statements[statement].Face <= face; ++statement)
+                apply(chunk.Statements[statement]);
+
+            if (!isMeshOpen)
+            {
+                for (uint32_t position : vertexPositions)
+                    heads[position] = INVALID_INDEX;
+
+                nexts.clear();
+                vertexPositions.clear();
+                vertexTexCoords.clear();
+
+                result.emplace_back();
+                result.back().FaceOffsets.push_back(0);
+
+                auto found = materials.find(material);
+                if (found != materials.end())
+                    result.back().Material = found->second;
+
+                isMeshOpen = true;
+            }
+
+            ObjMesh& mesh = result.back();
+
+            for (uint32_t i = 0; i < chunk.FaceSizes[face]; ++i, ++corner)
+            {
+                const Corner& source = chunk.Corners[corner];
+
+                if (source.Position < 0 || source.Position >= static_cast<int64_t>(positions.size()))
+                    return false;
+
+                if (source.TexCoord != NO_TEX_COORD && (source.TexCoord < 0 || source.TexCoord >= static_cast<int64_t>(texCoords.size())))
+                    return false;
+
+                uint32_t position = static_cast<uint32_t>(source.Position);
+
+                uint32_t vertex = heads[position];
+                while (vertex != INVALID_INDEX && vertexTexCoords[vertex] != source.TexCoord)
+                    vertex = nexts[vertex];
+
+                if (vertex == INVALID_INDEX)
+                {
+                    vertex = static_cast<uint32_t>(mesh.Vertices.size());
+
+                    glm::vec2 texCoord(-1.0f);
+                    if (source.TexCoord != NO_TEX_COORD)
+                        texCoord = glm::vec2(texCoords[source.TexCoord].x, 1.0f - texCoords[source.TexCoord].y);
+
+                    mesh.Vertices.emplace_back(positions[position], texCoord);
+
+                    nexts.push_back(heads[position]);
+                    heads[position] = vertex;
+                    vertexPositions.push_back(position);
+                    vertexTexCoords.push_back(source.TexCoord);
+                }
+
+                mesh.Corners.push_back(vertex);
+            }
+
+            mesh.FaceOffsets.push_back(static_cast<uint32_t>(mesh.Corners.size()));
+        }
+
+        for (; statement < chunk.Statements.size(); ++statement)
+            apply(chunk.Statements[statement]);
+    }
+
+    meshes = std::move(result);
+    return true;
+}
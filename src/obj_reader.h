@@ -0,0 +1,41 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_OBJ_READER_H_
+#define CATMULL_CLARK_SUBDIVITION_OBJ_READER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "vertex.h"
+
+namespace CatmullClarkSubdivision
+{
+    // texture file names as written in the .mtl, empty when the material has no such map
+    struct ObjMaterial
+    {
+        std::string DiffuseMap;  // map_Kd
+        std::string SpecularMap; // map_Ks
+        std::string BumpMap;     // map_Bump, bump
+        std::string AmbientMap;  // map_Ka
+    };
+
+    // Faces of one object and material. Corners sharing both the position and the texture coordinate share a vertex,
+    // vertices come in the order they are first used and texture coordinates are flipped as assimp's aiProcess_FlipUVs does
+    struct ObjMesh
+    {
+        std::vector<Vertex>   Vertices;
+        std::vector<uint32_t> FaceOffsets; // face f has the corners Corners[FaceOffsets[f] .. FaceOffsets[f + 1])
+        std::vector<uint32_t> Corners;     // vertex indices
+        ObjMaterial           Material;
+
+        uint32_t getFacesCount() const { return FaceOffsets.empty() ? 0 : static_cast<uint32_t>(FaceOffsets.size() - 1); }
+    };
+
+    // Reads a Wavefront OBJ and the material libraries it names. The file is mapped, split into line aligned chunks
+    // parsed on the thread pool and merged in file order. A new mesh starts with every object and material change.
+    // Normals, groups, smoothing, lines and points are skipped. False when the file can't be read or a face
+    // refers to a vertex the file doesn't have
+    bool readObj(const std::string& path, std::vector<ObjMesh>& meshes);
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_OBJ_READER_H_
@@ -8,14 +8,34 @@
 
 using namespace CatmullClarkSubdivision;
 
-void Shader::loadShader(const char* vertexPath, const char* fragmentPath)
+namespace
 {
-    m_id = glCreateProgram();
-
-    compile(vertexPath, GL_VERTEX_SHADER);
-    compile(fragmentPath, GL_FRAGMENT_SHADER);
+    bool isSampler(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_1D_SHADOW:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_1D_ARRAY:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_2D_MULTISAMPLE:
+        case GL_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
 
-    glLinkProgram(m_id);
+void Shader::loadShader(const char* vertexPath, const char* fragmentPath)
+{
+    loadSources(readSource(vertexPath), readSource(fragmentPath));
 
     /*
     const char* tmp;
@@ -46,7 +66,79 @@ void Shader::loadShader(const char* vertexPath, const char* fragmentPath)
     */
 }
 
-void Shader::compile(const char* path, GLenum type)
+void Shader::loadSources(const std::string& vertexCode, const std::string& fragmentCode, bool isRetrievable)
+{
+    release();
+
+    m_id = glCreateProgram();
+
+    if (isRetrievable)
+        glProgramParameteri(m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    compile(vertexCode, GL_VERTEX_SHADER);
+    compile(fragmentCode, GL_FRAGMENT_SHADER);
+
+    glLinkProgram(m_id);
+
+    int isLinked = 0;
+    glGetProgramiv(m_id, GL_LINK_STATUS, &isLinked);
+    if (!isLinked)
+    {
+        release();
+        throw std::exception("OPENGL: Can't link shader program");
+    }
+
+    reflectUniforms();
+}
+
+bool Shader::loadBinary(unsigned format, const std::vector<char>& binary)
+{
+    release();
+
+    m_id = glCreateProgram();
+    glProgramBinary(m_id, format, binary.data(), static_cast<int>(binary.size()));
+
+    int isLinked = 0;
+    glGetProgramiv(m_id, GL_LINK_STATUS, &isLinked);
+    if (!isLinked)
+    {
+        release();
+        return false;
+    }
+
+    reflectUniforms();
+    return true;
+}
+
+bool Shader::getBinary(unsigned& format, std::vector<char>& binary) const
+{
+    int length = 0;
+    glGetProgramiv(m_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+
+    binary.resize(static_cast<size_t>(length));
+
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(m_id, length, &length, &binaryFormat, binary.data());
+
+    binary.resize(static_cast<size_t>(length));
+    format = binaryFormat;
+
+    return length > 0;
+}
+
+void Shader::release()
+{
+    if (m_id)
+        glDeleteProgram(m_id);
+
+    m_id = 0;
+    m_uniforms.clear();
+    m_samplerUnits.clear();
+}
+
+std::string Shader::readSource(const char* path)
 {
     std::ifstream file;
     file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
@@ -56,17 +148,69 @@ void Shader::compile(const char* path, GLenum type)
     stream.str(std::string());
     stream << file.rdbuf();
     file.close();
-    std::string code = stream.str();
 
-    // Compile fragment shader
+    return stream.str();
+}
+
+void Shader::compile(const std::string& code, GLenum type)
+{
+    // Compile the stage
     unsigned id = glCreateShader(type);
     const char* tmp = code.c_str();
     glShaderSource(id, 1, &tmp, nullptr);
     glCompileShader(id);
-    checkError(id, "Can't compile fragment shader");
+    checkError(id, type == GL_VERTEX_SHADER ? "Can't compile vertex shader" : "Can't compile fragment shader");
 
     glAttachShader(m_id, id);
     glDeleteShader(id);
+}
 
-    checkError(m_id, "Can't execute shader program");
+void Shader::reflectUniforms()
+{
+    m_uniforms.clear();
+    m_samplerUnits.clear();
+
+    int usedUnitsCount = 0;
+
+    int count = 0;
+    int maxLength = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::string name(static_cast<size_t>(maxLength) + 1, '\0');
+
+    for (int i = 0; i < count; ++i)
+    {
+        int length = 0;
+        int size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_id, static_cast<unsigned>(i), static_cast<int>(name.size()), &length, &size, &type, &name[0]);
+
+        std::string uniform = name.substr(0, static_cast<size_t>(length));
+        int location = glGetUniformLocation(m_id, uniform.c_str());
+
+        // uniforms inside blocks have no location
+        if (location < 0)
+            continue;
+
+        m_uniforms[uniform] = location;
+
+        // every sampler gets its own units once, models never repoint them
+        if (isSampler(type))
+        {
+            std::vector<int> units(static_cast<size_t>(size));
+            for (int& unit : units)
+                unit = usedUnitsCount++;
+
+            glProgramUniform1iv(m_id, location, size, units.data());
+            m_samplerUnits[uniform] = units.front();
+
+            if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+                m_samplerUnits[uniform.substr(0, uniform.size() - 3)] = units.front();
+        }
+
+        // arrays are reported as name[0], they are also reachable by their plain name
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+            m_uniforms[uniform.substr(0, uniform.size() - 3)] = location;
+    }
 }
@@ -4,6 +4,8 @@
 
 #include <exception>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 //#include <gl/glew.h>
 #undef APIENTRY
@@ -13,14 +15,42 @@
 
 namespace CatmullClarkSubdivision
 {
+    // Location of an active uniform resolved once through Shader::getUniform, the type picks the glUniform call
+    template <typename T>
+    class Uniform
+    {
+    public:
+        Uniform() { }
+        explicit Uniform(int location) : m_location { location } { }
+
+        int getLocation() const { return m_location; }
+        bool isValid() const    { return m_location >= 0; }
+
+    private:
+        int m_location = -1;
+    };
+
     class Shader
     {
     public:
         Shader() { }
-        ~Shader() { }
+        ~Shader() { release(); }
+
+        // the shader owns its program, it is shared through ShaderCache instead of being copied
+        Shader(const Shader& other)            = delete;
+        Shader(Shader&& other)                 = delete;
+        Shader& operator=(const Shader& other) = delete;
+        Shader& operator=(Shader&& other)      = delete;
 
         void loadShader(const char* vertexPath, const char* fragmentPath);
-        void release() { glDeleteProgram(m_id); }
+        // isRetrievable asks the driver to keep the linked binary around for getBinary
+        void loadSources(const std::string& vertexCode, const std::string& fragmentCode, bool isRetrievable = false);
+        // false if the driver rejects the binary (another driver or GPU), the shader is left empty then
+        bool loadBinary(unsigned format, const std::vector<char>& binary);
+        bool getBinary(unsigned& format, std::vector<char>& binary) const;
+        void release();
+
+        static std::string readSource(const char* path);
 
         // activate the shader
         // ------------------------------------------------------------------------
@@ -31,83 +61,113 @@ namespace CatmullClarkSubdivision
 
         unsigned getId() const { return m_id; }
 
+        // location from the table reflected after linking, -1 if the program has no such active uniform
+        int getUniformLocation(const char* name) const
+        {
+            auto found = m_uniforms.find(name);
+            return found != m_uniforms.end() ? found->second : -1;
+        }
+
+        template <typename T>
+        Uniform<T> getUniform(const char* name) const { return Uniform<T>(getUniformLocation(name)); }
+
+        // texture unit the sampler was pointed at after linking, -1 if the program has no such sampler.
+        // Units belong to the program, so every model sharing it binds its textures the same way
+        int getSamplerUnit(const char* name) const
+        {
+            auto found = m_samplerUnits.find(name);
+            return found != m_samplerUnits.end() ? found->second : -1;
+        }
+
+        // typed uniform updates, no lookup at all
+        // ------------------------------------------------------------------------
+        void set(Uniform<bool> uniform, bool value) const                    { glUniform1i(uniform.getLocation(), (int)value); }
+        void set(Uniform<int> uniform, int value) const                      { glUniform1i(uniform.getLocation(), value); }
+        void set(Uniform<float> uniform, float value) const                  { glUniform1f(uniform.getLocation(), value); }
+        void set(Uniform<glm::vec2> uniform, const glm::vec2& value) const   { glUniform2fv(uniform.getLocation(), 1, &value[0]); }
+        void set(Uniform<glm::vec3> uniform, const glm::vec3& value) const   { glUniform3fv(uniform.getLocation(), 1, &value[0]); }
+        void set(Uniform<glm::vec4> uniform, const glm::vec4& value) const   { glUniform4fv(uniform.getLocation(), 1, &value[0]); }
+        void set(Uniform<glm::mat2> uniform, const glm::mat2& mat) const     { glUniformMatrix2fv(uniform.getLocation(), 1, GL_FALSE, &mat[0][0]); }
+        void set(Uniform<glm::mat3> uniform, const glm::mat3& mat) const     { glUniformMatrix3fv(uniform.getLocation(), 1, GL_FALSE, &mat[0][0]); }
+        void set(Uniform<glm::mat4> uniform, const glm::mat4& mat) const     { glUniformMatrix4fv(uniform.getLocation(), 1, GL_FALSE, &mat[0][0]); }
+
         // utility uniform functions
         // ------------------------------------------------------------------------
         void setBool(const char* name, bool value) const
         {
             getId();
-            glUniform1i(glGetUniformLocation(m_id, name), (int)value);
+            glUniform1i(getUniformLocation(name), (int)value);
         }
 
         // ------------------------------------------------------------------------
         void setInt(const char* name, int value) const
         {
             getId();
-            glUniform1i(glGetUniformLocation(m_id, name), value);
+            glUniform1i(getUniformLocation(name), value);
         }
 
         // ------------------------------------------------------------------------
         void setFloat(const char* name, float value) const
         {
             getId();
-            glUniform1f(glGetUniformLocation(m_id, name), value);
+            glUniform1f(getUniformLocation(name), value);
         }
 
         // ------------------------------------------------------------------------
         void setVec2(const char* name, const glm::vec2& value) const
         {
             getId();
-            glUniform2fv(glGetUniformLocation(m_id, name), 1, &value[0]);
+            glUniform2fv(getUniformLocation(name), 1, &value[0]);
         }
         void setVec2(const char* name, float x, float y) const
         {
             getId();
-            glUniform2f(glGetUniformLocation(m_id, name), x, y);
+            glUniform2f(getUniformLocation(name), x, y);
         }
 
         // ------------------------------------------------------------------------
         void setVec3(const char* name, const glm::vec3& value) const
         {
             getId();
-            glUniform3fv(glGetUniformLocation(m_id, name), 1, &value[0]);
+            glUniform3fv(getUniformLocation(name), 1, &value[0]);
         }
         void setVec3(const char* name, float x, float y, float z) const
         {
             getId();
-            glUniform3f(glGetUniformLocation(m_id, name), x, y, z);
+            glUniform3f(getUniformLocation(name), x, y, z);
         }
 
         // ------------------------------------------------------------------------
         void setVec4(const char* name, const glm::vec4& value) const
         {
             getId();
-            glUniform4fv(glGetUniformLocation(m_id, name), 1, &value[0]);
+            glUniform4fv(getUniformLocation(name), 1, &value[0]);
         }
         void setVec4(const char* name, float x, float y, float z, float w)
         {
             getId();
-            glUniform4f(glGetUniformLocation(m_id, name), x, y, z, w);
+            glUniform4f(getUniformLocation(name), x, y, z, w);
         }
 
         // ------------------------------------------------------------------------
         void setMat2(const char* name, const glm::mat2& mat) const
         {
             getId();
-            glUniformMatrix2fv(glGetUniformLocation(m_id, name), 1, GL_FALSE, &mat[0][0]);
+            glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
         }
 
         // ------------------------------------------------------------------------
         void setMat3(const char* name, const glm::mat3& mat) const
         {
             getId();
-            glUniformMatrix3fv(glGetUniformLocation(m_id, name), 1, GL_FALSE, &mat[0][0]);
+            glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
         }
 
         // ------------------------------------------------------------------------
         void setMat4(const char* name, const glm::mat4& mat) const
         {
             getId();
-            glUniformMatrix4fv(glGetUniformLocation(m_id, name), 1, GL_FALSE, &mat[0][0]);
+            glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
         }
 
     private:
@@ -123,9 +183,12 @@ namespace CatmullClarkSubdivision
             }
         }
 
-        void compile(const char* path, GLenum type);
+        void compile(const std::string& code, GLenum type);
+        void reflectUniforms();
 
         unsigned m_id = 0;
+        std::unordered_map<std::string, int> m_uniforms;     // name -> location of every active uniform
+        std::unordered_map<std::string, int> m_samplerUnits; // sampler name -> texture unit, in declaration order
     };
 }
 
@@ -0,0 +1,125 @@
+#include "shader_cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    const uint64_t FNV_PRIME  = 1099511628211ull;
+
+    // FNV-1a, strings are terminated so "ab" + "c" and "a" + "bc" differ
+    uint64_t hashString(uint64_t hash, const std::string& value)
+    {
+        for (char byte : value)
+        {
+            hash ^= static_cast<unsigned char>(byte);
+            hash *= FNV_PRIME;
+        }
+
+        hash ^= 0xFF;
+        hash *= FNV_PRIME;
+        return hash;
+    }
+
+    std::string toHex(uint64_t value)
+    {
+        char buffer[17] = { 0 };
+        std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+        return buffer;
+    }
+
+    std::string getGLString(GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+}
+
+ShaderCache& ShaderCache::getInstance()
+{
+    static ShaderCache instance;
+    return instance;
+}
+
+std::shared_ptr<Shader> ShaderCache::getShader(const char* vertexPath, const char* fragmentPath)
+{
+    std::string vertexCode = Shader::readSource(vertexPath);
+    std::string fragmentCode = Shader::readSource(fragmentPath);
+
+    uint64_t sourcesHash = hashString(hashString(FNV_OFFSET, vertexCode), fragmentCode);
+
+    std::string key = std::string(vertexPath).append("|").append(fragmentPath).append("|").append(toHex(sourcesHash));
+
+    auto found = m_shaders.find(key);
+    if (found != m_shaders.end())
+    {
+        if (std::shared_ptr<Shader> shader = found->second.lock())
+            return shader;
+    }
+
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>();
+
+    // binaries only fit the driver that produced them, its identity is part of the file name
+    std::string binaryPath;
+    if (!m_binaryDirectory.empty())
+    {
+        uint64_t binaryHash = sourcesHash;
+        binaryHash = hashString(binaryHash, getGLString(GL_VENDOR));
+        binaryHash = hashString(binaryHash, getGLString(GL_RENDERER));
+        binaryHash = hashString(binaryHash, getGLString(GL_VERSION));
+
+        binaryPath = std::string(m_binaryDirectory).append("\\").append(toHex(binaryHash)).append(".bin");
+    }
+
+    if (binaryPath.empty() || !loadBinary(*shader, binaryPath))
+    {
+        shader->loadSources(vertexCode, fragmentCode, !binaryPath.empty());
+
+        if (!binaryPath.empty())
+            saveBinary(*shader, binaryPath);
+    }
+
+    m_shaders[key] = shader;
+    return shader;
+}
+
+bool ShaderCache::loadBinary(Shader& shader, const std::string& path) const
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t format = 0;
+    if (!file.read(reinterpret_cast<char*>(&format), sizeof(format)))
+        return false;
+
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (binary.empty())
+        return false;
+
+    // a stale or foreign binary is simply rejected, the caller compiles from source and overwrites it
+    return shader.loadBinary(format, binary);
+}
+
+void ShaderCache::saveBinary(const Shader& shader, const std::string& path) const
+{
+    unsigned format = 0;
+    std::vector<char> binary;
+    if (!shader.getBinary(format, binary))
+        return;
+
+    // failing to write only costs the next start a compilation
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return;
+
+    uint32_t header = format;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+}
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_SHADER_CACHE_H_
+#define CATMULL_CLARK_SUBDIVITION_SHADER_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "shader.h"
+
+namespace CatmullClarkSubdivision
+{
+    // Programs shared by every model, each distinct pair of sources is compiled once and lives while someone holds it.
+    // With a binary directory set, linked programs are written there too and later runs link them without GLSL.
+    // Only to be used on the thread owning the GL context
+    class ShaderCache
+    {
+    public:
+        ShaderCache(const ShaderCache& other)            = delete;
+        ShaderCache(ShaderCache&& other)                 = delete;
+        ShaderCache& operator=(const ShaderCache& other) = delete;
+        ShaderCache& operator=(ShaderCache&& other)      = delete;
+
+        static ShaderCache& getInstance();
+
+        // the directory has to exist, empty turns the on-disk cache off
+        void setBinaryDirectory(const std::string& directory) { m_binaryDirectory = directory; }
+
+        // keyed by both paths and a hash of both sources, so an edited file is compiled again
+        std::shared_ptr<Shader> getShader(const char* vertexPath, const char* fragmentPath);
+
+    private:
+        ShaderCache() { }
+
+        bool loadBinary(Shader& shader, const std::string& path) const;
+        void saveBinary(const Shader& shader, const std::string& path) const;
+
+        std::string m_binaryDirectory;
+        std::unordered_map<std::string, std::weak_ptr<Shader>> m_shaders; // paths and sources hash -> program in use
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_SHADER_CACHE_H_
@@ -5,9 +5,13 @@ layout (location = 1) in vec2 TextureCoords;
 
 out vec2 TexCoords;
 
+layout (std140, binding = 0) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
@@ -0,0 +1,342 @@
+#include "stencil_evaluator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#include <immintrin.h>
+
+#include "thread_pool.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define STENCIL_KERNEL_TARGET(isa)
+#else
+#include <cpuid.h>
+#define STENCIL_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    // positions and texture coordinates together
+    const uint32_t MAX_STREAMS = 5;
+
+    const uint32_t STENCILS_GRAIN = 8192;
+
+    void cpuid(int registers[4], int leaf, int subleaf)
+    {
+#ifdef _MSC_VER
+        __cpuidex(registers, leaf, subleaf);
+#else
+        unsigned a = 0, b = 0, c = 0, d = 0;
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        registers[0] = static_cast<int>(a);
+        registers[1] = static_cast<int>(b);
+        registers[2] = static_cast<int>(c);
+        registers[3] = static_cast<int>(d);
+#endif
+    }
+
+    STENCIL_KERNEL_TARGET("xsave")
+    uint64_t xgetbv()
+    {
+        return _xgetbv(0);
+    }
+
+    EInstructionSet detectInstructionSet()
+    {
+        int registers[4] = { 0 };
+
+        cpuid(registers, 0, 0);
+        int maxLeaf = registers[0];
+
+        if (maxLeaf < 1)
+            return EInstructionSet::EScalar;
+
+        cpuid(registers, 1, 0);
+        bool sse41   = (registers[2] & (1 << 19)) != 0;
+        bool osxsave = (registers[2] & (1 << 27)) != 0;
+        bool avx     = (registers[2] & (1 << 28)) != 0;
+
+        if (!sse41)
+            return EInstructionSet::EScalar;
+
+        // the OS has to save the wide registers on context switches, otherwise the wide kernels are unusable
+        if (!osxsave || !avx || maxLeaf < 7)
+            return EInstructionSet::ESSE41;
+
+        uint64_t xcr0 = xgetbv();
+        if ((xcr0 & 0x6) != 0x6)
+            return EInstructionSet::ESSE41;
+
+        cpuid(registers, 7, 0);
+        bool avx2    = (registers[1] & (1 << 5)) != 0;
+        bool avx512f = (registers[1] & (1 << 16)) != 0;
+
+        if (!avx2)
+            return EInstructionSet::ESSE41;
+
+        if (avx512f && (xcr0 & 0xE6) == 0xE6)
+            return EInstructionSet::EAVX512;
+
+        return EInstructionSet::EAVX2;
+    }
+
+    void evaluateScalar(const StencilTable& table, uint32_t begin, uint32_t end, const float* const* sources, uint32_t stride, float* const* destinations, uint32_t streamsCount)
+    {
+        const uint32_t* indices = table.Indices.data();
+        const float* weights = table.Weights.data();
+
+        for (uint32_t s = begin; s < end; ++s)
+        {
+            float sums[MAX_STREAMS] = { 0.0f };
+
+            for (uint32_t i = table.Offsets[s]; i < table.Offsets[s + 1]; ++i)
+            {
+                for (uint32_t k = 0; k < streamsCount; ++k)
+                    sums[k] += weights[i] * sources[k][indices[i] * stride];
+            }
+
+            for (uint32_t k = 0; k < streamsCount; ++k)
+                destinations[k][s - begin] = sums[k];
+        }
+    }
+
+    // the stencils the vector kernels leave over, fewer than one group
+    void evaluateTail(const StencilTable& table, uint32_t begin, uint32_t tail, uint32_t end, const float* const* sources, uint32_t stride, float* const* destinations, uint32_t streamsCount)
+    {
+        float* tailDestinations[MAX_STREAMS];
+        for (uint32_t k = 0; k < streamsCount; ++k)
+            tailDestinations[k] = destinations[k] + (tail - begin);
+
+        evaluateScalar(table, tail, end, sources, stride, tailDestinations, streamsCount);
+    }
+
+    // The vector kernels give every lane its own stencil, so a step makes a whole group of consecutive outputs and
+    // stores them without a horizontal sum. Stencils are short (4 to about 9 entries) and mixed in length, a lane
+    // whose stencil is done is masked off until the longest one in the group ends. Each lane adds its entries in
+    // stencil order like the scalar kernel, results only differ where a compiler fuses the multiply-adds
+
+    // no gather before AVX2: the entries of the four lanes are loaded one by one
+    STENCIL_KERNEL_TARGET("sse4.1")
+    void evaluateSSE41(const StencilTable& table, uint32_t begin, uint32_t end, const float* const* sources, uint32_t stride, float* const* destinations, uint32_t streamsCount)
+    {
+        const uint32_t* offsets = table.Offsets.data();
+        const uint32_t* indices = table.Indices.data();
+        const float* weights = table.Weights.data();
+
+        uint32_t s = begin;
+
+        for (; s + 4 <= end; s += 4)
+        {
+            __m128i cursor = _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets + s));
+            __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets + s + 1));
+
+            __m128 sums[MAX_STREAMS];
+            for (uint32_t k = 0; k < streamsCount; ++k)
+                sums[k] = _mm_setzero_ps();
+
+            for (__m128i active = _mm_cmpgt_epi32(last, cursor); !_mm_testz_si128(active, active); active = _mm_cmpgt_epi32(last, cursor))
+            {
+                // finished lanes read the first entry and their products are dropped, so every load stays in bounds
+                __m128i entry = _mm_and_si128(cursor, active);
+                __m128 activeMask = _mm_castsi128_ps(active);
+
+                uint32_t e0 = static_cast<uint32_t>(_mm_cvtsi128_si32(entry));
+                uint32_t e1 = static_cast<uint32_t>(_mm_extract_epi32(entry, 1));
+                uint32_t e2 = static_cast<uint32_t>(_mm_extract_epi32(entry, 2));
+                uint32_t e3 = static_cast<uint32_t>(_mm_extract_epi32(entry, 3));
+
+                uint32_t i0 = indices[e0] * stride, i1 = indices[e1] * stride, i2 = indices[e2] * stride, i3 = indices[e3] * stride;
+                __m128 weight = _mm_set_ps(weights[e3], weights[e2], weights[e1], weights[e0]);
+
+                for (uint32_t k = 0; k < streamsCount; ++k)
+                {
+                    const float* source = sources[k];
+                    __m128 value = _mm_set_ps(source[i3], source[i2], source[i1], source[i0]);
+                    sums[k] = _mm_add_ps(sums[k], _mm_and_ps(_mm_mul_ps(weight, value), activeMask));
+                }
+
+                // active lanes are all ones, subtracting them moves each to its next entry
+                cursor = _mm_sub_epi32(cursor, active);
+            }
+
+            for (uint32_t k = 0; k < streamsCount; ++k)
+                _mm_storeu_ps(destinations[k] + (s - begin), sums[k]);
+        }
+
+        evaluateTail(table, begin, s, end, sources, stride, destinations, streamsCount);
+    }
+
+    STENCIL_KERNEL_TARGET("avx2")
+    void evaluateAVX2(const StencilTable& table, uint32_t begin, uint32_t end, const float* const* sources, uint32_t stride, float* const* destinations, uint32_t streamsCount)
+    {
+        const uint32_t* offsets = table.Offsets.data();
+        const int* indices = reinterpret_cast<const int*>(table.Indices.data());
+        const float* weights = table.Weights.data();
+
+        const __m256i strides = _mm256_set1_epi32(static_cast<int>(stride));
+
+        uint32_t s = begin;
+
+        for (; s + 8 <= end; s += 8)
+        {
+            __m256i cursor = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + s));
+            __m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + s + 1));
+
+            __m256 sums[MAX_STREAMS];
+            for (uint32_t k = 0; k < streamsCount; ++k)
+                sums[k] = _mm256_setzero_ps();
+
+            for (__m256i active = _mm256_cmpgt_epi32(last, cursor); !_mm256_testz_si256(active, active); active = _mm256_cmpgt_epi32(last, cursor))
+            {
+                __m256 activeMask = _mm256_castsi256_ps(active);
+
+                __m256i index = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), indices, cursor, active, 4);
+                __m256 weight = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), weights, cursor, activeMask, 4);
+
+                index = _mm256_mullo_epi32(index, strides);
+
+                for (uint32_t k = 0; k < streamsCount; ++k)
+                {
+                    __m256 value = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), sources[k], index, activeMask, 4);
+                    sums[k] = _mm256_add_ps(sums[k], _mm256_mul_ps(weight, value));
+                }
+
+                cursor = _mm256_sub_epi32(cursor, active);
+            }
+
+            for (uint32_t k = 0; k < streamsCount; ++k)
+                _mm256_storeu_ps(destinations[k] + (s - begin), sums[k]);
+        }
+
+        evaluateTail(table, begin, s, end, sources, stride, destinations, streamsCount);
+    }
+
+    // the last group is masked too, so there is no scalar tail
+    STENCIL_KERNEL_TARGET("avx512f")
+    void evaluateAVX512(const StencilTable& table, uint32_t begin, uint32_t end, const float* const* sources, uint32_t stride, float* const* destinations, uint32_t streamsCount)
+    {
+        const uint32_t* offsets = table.Offsets.data();
+        const uint32_t* indices = table.Indices.data();
+        const float* weights = table.Weights.data();
+
+        const __m512i one = _mm512_set1_epi32(1);
+        const __m512i strides = _mm512_set1_epi32(static_cast<int>(stride));
+
+        for (uint32_t s = begin; s < end; s += 16)
+        {
+            __mmask16 lanes = end - s >= 16 ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << (end - s)) - 1);
+
+            __m512i cursor = _mm512_maskz_loadu_epi32(lanes, offsets + s);
+            __m512i last = _mm512_maskz_loadu_epi32(lanes, offsets + s + 1);
+
+            __m512 sums[MAX_STREAMS];
+            for (uint32_t k = 0; k < streamsCount; ++k)
+                sums[k] = _mm512_setzero_ps();
+
+            for (__mmask16 active = _mm512_cmplt_epu32_mask(cursor, last); active; active = _mm512_cmplt_epu32_mask(cursor, last))
+            {
+                __m512i index = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), active, cursor, indices, 4);
+                __m512 weight = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), active, cursor, weights, 4);
+
+                index = _mm512_mullo_epi32(index, strides);
+
+                for (uint32_t k = 0; k < streamsCount; ++k)
+                {
+                    __m512 value = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), active, index, sources[k], 4);
+                    sums[k] = _mm512_add_ps(sums[k], _mm512_mul_ps(weight, value));
+                }
+
+                cursor = _mm512_mask_add_epi32(cursor, active, cursor, one);
+            }
+
+            for (uint32_t k = 0; k < streamsCount; ++k)
+                _mm512_mask_storeu_ps(destinations[k] + (s - begin), lanes, sums[k]);
+        }
+    }
+
+    StencilKernel getKernel(EInstructionSet instructionSet)
+    {
+        switch (instructionSet)
+        {
+            case EInstructionSet::EAVX512: return evaluateAVX512;
+            case EInstructionSet::EAVX2:   return evaluateAVX2;
+            case EInstructionSet::ESSE41:  return evaluateSSE41;
+            default:                       return evaluateScalar;
+        }
+    }
+
+    std::atomic<int>& selectedInstructionSet()
+    {
+        static std::atomic<int> instructionSet { static_cast<int>(getSupportedInstructionSet()) };
+        return instructionSet;
+    }
+}
+
+EInstructionSet CatmullClarkSubdivision::getSupportedInstructionSet()
+{
+    static const EInstructionSet supported = detectInstructionSet();
+    return supported;
+}
+
+EInstructionSet CatmullClarkSubdivision::getStencilInstructionSet()
+{
+    return static_cast<EInstructionSet>(selectedInstructionSet().load());
+}
+
+void CatmullClarkSubdivision::setStencilInstructionSet(EInstructionSet instructionSet)
+{
+    int clamped = std::min(static_cast<int>(instructionSet), static_cast<int>(getSupportedInstructionSet()));
+    selectedInstructionSet().store(clamped);
+}
+
+const char* CatmullClarkSubdivision::getInstructionSetName(EInstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+        case EInstructionSet::EAVX512: return "AVX-512";
+        case EInstructionSet::EAVX2:   return "AVX2";
+        case EInstructionSet::ESSE41:  return "SSE4.1";
+        default:                       return "Scalar";
+    }
+}
+
+StencilKernel CatmullClarkSubdivision::getStencilKernel()
+{
+    return getKernel(getStencilInstructionSet());
+}
+
+void CatmullClarkSubdivision::evaluateStencils(const StencilTable& table, const float* const* sources, float* const* destinations, uint32_t streamsCount, uint32_t stride)
+{
+    if (streamsCount > MAX_STREAMS)
+        throw std::runtime_error("Too many streams for the stencil evaluator");
+
+    StencilKernel kernel = getStencilKernel();
+
+    // stencils are independent, so the split doesn't change the result. Blocks are evaluated on the stack and
+    // spread to the strided destinations while they are still in cache
+    ThreadPool::getInstance().parallelFor(table.getStencilsCount(), STENCILS_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        float block[MAX_STREAMS][STENCILS_BLOCK];
+        float* blockDestinations[MAX_STREAMS];
+
+        for (uint32_t k = 0; k < streamsCount; ++k)
+            blockDestinations[k] = block[k];
+
+        for (uint32_t blockBegin = begin; blockBegin < end; blockBegin += STENCILS_BLOCK)
+        {
+            uint32_t blockEnd = std::min(blockBegin + STENCILS_BLOCK, end);
+
+            kernel(table, blockBegin, blockEnd, sources, stride, blockDestinations, streamsCount);
+
+            for (uint32_t k = 0; k < streamsCount; ++k)
+            {
+                for (uint32_t s = blockBegin; s < blockEnd; ++s)
+                    destinations[k][static_cast<size_t>(s) * stride] = block[k][s - blockBegin];
+            }
+        }
+    });
+}
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_STENCIL_EVALUATOR_H_
+#define CATMULL_CLARK_SUBDIVITION_STENCIL_EVALUATOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "stencil_table.h"
+
+namespace CatmullClarkSubdivision
+{
+    enum class EInstructionSet
+    {
+        EScalar,
+        ESSE41,
+        EAVX2,
+        EAVX512
+    };
+
+    // widest kernel the CPU and OS support, detected once through CPUID
+    EInstructionSet getSupportedInstructionSet();
+
+    // kernel used by evaluateStencils, defaults to the supported one. Requests above it are clamped
+    EInstructionSet getStencilInstructionSet();
+    void setStencilInstructionSet(EInstructionSet instructionSet);
+
+    const char* getInstructionSetName(EInstructionSet instructionSet);
+
+    // Kernels evaluate stencils [begin, end) into destinations[k][s - begin] for each of the streams. Sources are
+    // read in place, the value of vertex i in stream k is sources[k][i * stride] (5 reads a Vertex array as is)
+    typedef void (*StencilKernel)(const StencilTable& table, uint32_t begin, uint32_t end, const float* const* sources, uint32_t stride, float* const* destinations, uint32_t streamsCount);
+
+    // the kernel of the selected instruction set, for callers walking the stencils in blocks of their own
+    StencilKernel getStencilKernel();
+
+    // longest block of stencils evaluated at once, small enough for the results to stay in L1
+    const uint32_t STENCILS_BLOCK = 256;
+
+    // destinations[k][s * stride] = sum of Weights[i] * sources[k][Indices[i] * stride] over stencil s, for each of the streams
+    void evaluateStencils(const StencilTable& table, const float* const* sources, float* const* destinations, uint32_t streamsCount, uint32_t stride = 1);
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_STENCIL_EVALUATOR_H_
@@ -0,0 +1,214 @@
+#include "stencil_table.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+#include "stencil_evaluator.h"
+#include "thread_pool.h"
+
+using namespace CatmullClarkSubdivision;
+
+void StencilTable::clear()
+{
+    Offsets.assign(1, 0);
+    Indices.clear();
+    Weights.clear();
+}
+
+void StencilTable::reserve(size_t stencilsCount, size_t entriesCount)
+{
+    Offsets.reserve(stencilsCount + 1);
+    Indices.reserve(entriesCount);
+    Weights.reserve(entriesCount);
+}
+
+void StencilTable::push(uint32_t index, float weight)
+{
+    // stencils are short (one-ring sized), a linear search beats any lookup structure here
+    for (size_t i = Offsets.back(); i < Indices.size(); ++i)
+    {
+        if (Indices[i] == index)
+        {
+            Weights[i] += weight;
+            return;
+        }
+    }
+
+    Indices.push_back(index);
+    Weights.push_back(weight);
+}
+
+StencilTable CatmullClarkSubdivision::composeStencils(const StencilTable& child, const StencilTable& parent)
+{
+    uint32_t sourcesCount = 0;
+    for (uint32_t index : parent.Indices)
+        sourcesCount = std::max(sourcesCount, index + 1);
+
+    // dense accumulator over parent sources, reset through the touched list after every stencil
+    std::vector<float> accumulator(sourcesCount, 0.0f);
+    std::vector<uint32_t> marks(sourcesCount, 0xFFFFFFFFu);
+    std::vector<uint32_t> touched;
+
+    StencilTable result;
+    result.reserve(child.getStencilsCount(), child.Indices.size() * 4);
+
+    for (uint32_t s = 0; s < child.getStencilsCount(); ++s)
+    {
+        touched.clear();
+
+        for (uint32_t i = child.Offsets[s]; i < child.Offsets[s + 1]; ++i)
+        {
+            uint32_t row = child.Indices[i];
+            float weight = child.Weights[i];
+
+            for (uint32_t j = parent.Offsets[row]; j < parent.Offsets[row + 1]; ++j)
+            {
+                uint32_t source = parent.Indices[j];
+
+                if (marks[source] != s)
+                {
+                    marks[source] = s;
+                    accumulator[source] = 0.0f;
+                    touched.push_back(source);
+                }
+
+                accumulator[source] += weight * parent.Weights[j];
+            }
+        }
+
+        std::sort(touched.begin(), touched.end());
+
+        for (uint32_t source : touched)
+        {
+            result.Indices.push_back(source);
+            result.Weights.push_back(accumulator[source]);
+        }
+
+        result.close();
+    }
+
+    return result;
+}
+
+StencilTable CatmullClarkSubdivision::concatenateStencils(const std::vector<StencilTable>& parts)
+{
+    std::vector<uint32_t> stencilBases(parts.size() + 1, 0);
+    std::vector<uint32_t> entryBases(parts.size() + 1, 0);
+
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        stencilBases[i + 1] = stencilBases[i] + parts[i].getStencilsCount();
+        entryBases[i + 1] = entryBases[i] + static_cast<uint32_t>(parts[i].Indices.size());
+    }
+
+    StencilTable result;
+    result.Offsets.resize(stencilBases.back() + 1);
+    result.Indices.resize(entryBases.back());
+    result.Weights.resize(entryBases.back());
+    result.Offsets.back() = entryBases.back();
+
+    ThreadPool::getInstance().parallelFor(static_cast<uint32_t>(parts.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const StencilTable& part = parts[i];
+
+            for (uint32_t s = 0; s < part.getStencilsCount(); ++s)
+                result.Offsets[stencilBases[i] + s] = entryBases[i] + part.Offsets[s];
+
+            std::copy(part.Indices.begin(), part.Indices.end(), result.Indices.begin() + entryBases[i]);
+            std::copy(part.Weights.begin(), part.Weights.end(), result.Weights.begin() + entryBases[i]);
+        }
+    });
+
+    return result;
+}
+
+namespace
+{
+    // a Vertex array read as five interleaved streams, see StencilKernel
+    const uint32_t VERTEX_STRIDE = sizeof(Vertex) / sizeof(float);
+    const uint32_t POSITION_STREAM = offsetof(Vertex, Position) / sizeof(float);
+    const uint32_t TEXCOORD_STREAM = offsetof(Vertex, TexCoord) / sizeof(float);
+
+    const uint32_t VERTICES_GRAIN = 8192;
+
+    static_assert(sizeof(Vertex) == 5 * sizeof(float), "Vertex has to be tightly packed floats to be read as streams");
+}
+
+void CatmullClarkSubdivision::evaluatePositions(const StencilTable& table, const std::vector<Vertex>& source, std::vector<Vertex>& destination)
+{
+    destination.resize(table.getStencilsCount());
+
+    const float* sourceBase = reinterpret_cast<const float*>(source.data()) + POSITION_STREAM;
+    float* destinationBase = reinterpret_cast<float*>(destination.data()) + POSITION_STREAM;
+
+    const float* sources[3] = { sourceBase, sourceBase + 1, sourceBase + 2 };
+    float* destinations[3] = { destinationBase, destinationBase + 1, destinationBase + 2 };
+
+    evaluateStencils(table, sources, destinations, 3, VERTEX_STRIDE);
+}
+
+void CatmullClarkSubdivision::evaluateVertices(const StencilTable& positions, const StencilTable& texCoords, const std::vector<Vertex>& source,
+                                               Vertex* destination, glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+    const uint32_t count = positions.getStencilsCount();
+
+    if (texCoords.getStencilsCount() != count)
+        throw std::runtime_error("Position and texture coordinate stencils don't make the same vertices");
+
+    const float* sourceBase = reinterpret_cast<const float*>(source.data());
+
+    const float* positionSources[3] = { sourceBase + POSITION_STREAM, sourceBase + POSITION_STREAM + 1, sourceBase + POSITION_STREAM + 2 };
+    const float* texCoordSources[2] = { sourceBase + TEXCOORD_STREAM, sourceBase + TEXCOORD_STREAM + 1 };
+
+    StencilKernel kernel = getStencilKernel();
+
+    // one box per chunk, merged once every chunk is done
+    std::vector<glm::vec3> chunkMins((count + VERTICES_GRAIN - 1) / VERTICES_GRAIN, glm::vec3(std::numeric_limits<float>::max()));
+    std::vector<glm::vec3> chunkMaxs(chunkMins.size(), glm::vec3(std::numeric_limits<float>::lowest()));
+
+    // both tables over the same block, then each vertex is written whole and in order, as write-combined memory wants
+    ThreadPool::getInstance().parallelFor(count, VERTICES_GRAIN, [&](uint32_t begin, uint32_t end)
+    {
+        float block[5][STENCILS_BLOCK];
+        float* positionBlock[3] = { block[0], block[1], block[2] };
+        float* texCoordBlock[2] = { block[3], block[4] };
+
+        glm::vec3 chunkMin(std::numeric_limits<float>::max());
+        glm::vec3 chunkMax(std::numeric_limits<float>::lowest());
+
+        for (uint32_t blockBegin = begin; blockBegin < end; blockBegin += STENCILS_BLOCK)
+        {
+            uint32_t blockEnd = std::min(blockBegin + STENCILS_BLOCK, end);
+
+            kernel(positions, blockBegin, blockEnd, positionSources, VERTEX_STRIDE, positionBlock, 3);
+            kernel(texCoords, blockBegin, blockEnd, texCoordSources, VERTEX_STRIDE, texCoordBlock, 2);
+
+            for (uint32_t s = blockBegin; s < blockEnd; ++s)
+            {
+                uint32_t i = s - blockBegin;
+                glm::vec3 position(block[0][i], block[1][i], block[2][i]);
+
+                chunkMin = glm::min(chunkMin, position);
+                chunkMax = glm::max(chunkMax, position);
+
+                destination[s] = Vertex(position, glm::vec2(block[3][i], block[4][i]));
+            }
+        }
+
+        chunkMins[begin / VERTICES_GRAIN] = chunkMin;
+        chunkMaxs[begin / VERTICES_GRAIN] = chunkMax;
+    });
+
+    boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+
+    for (size_t i = 0; i < chunkMins.size(); ++i)
+    {
+        boundsMin = glm::min(boundsMin, chunkMins[i]);
+        boundsMax = glm::max(boundsMax, chunkMaxs[i]);
+    }
+}
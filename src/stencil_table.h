@@ -0,0 +1,46 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_STENCIL_TABLE_H_
+#define CATMULL_CLARK_SUBDIVITION_STENCIL_TABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "vertex.h"
+
+namespace CatmullClarkSubdivision
+{
+    // Sparse matrix in CSR form that expresses every refined vertex as a weighted sum of source vertices:
+    // stencil i is Indices/Weights[Offsets[i] .. Offsets[i + 1]).
+    struct StencilTable
+    {
+        uint32_t getStencilsCount() const { return static_cast<uint32_t>(Offsets.size() - 1); }
+
+        void clear();
+        void reserve(size_t stencilsCount, size_t entriesCount);
+
+        // adds a weighted source vertex to the open stencil, repeated indices are merged
+        void push(uint32_t index, float weight);
+        // closes the open stencil, following pushes start the next one
+        void close() { Offsets.push_back(static_cast<uint32_t>(Indices.size())); }
+
+        std::vector<uint32_t> Offsets { 0 };
+        std::vector<uint32_t> Indices;
+        std::vector<float>    Weights;
+    };
+
+    // expresses the stencils of child (over parent's stencils) directly over the sources of parent
+    StencilTable composeStencils(const StencilTable& child, const StencilTable& parent);
+
+    // joins tables built separately (e.g. per thread) into one, stencils keep their order
+    StencilTable concatenateStencils(const std::vector<StencilTable>& parts);
+
+    // positions of destination, sized to the stencils count, the texture coordinates are left as they are
+    void evaluatePositions(const StencilTable& table, const std::vector<Vertex>& source, std::vector<Vertex>& destination);
+
+    // whole vertices into destination[0, stencils count), which the caller sized (e.g. a mapped GL buffer), in one pass
+    // over both tables, along with the box around the evaluated positions
+    void evaluateVertices(const StencilTable& positions, const StencilTable& texCoords, const std::vector<Vertex>& source,
+                          Vertex* destination, glm::vec3& boundsMin, glm::vec3& boundsMax);
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_STENCIL_TABLE_H_
@@ -0,0 +1,24 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_SUBDIVISION_STATS_H_
+#define CATMULL_CLARK_SUBDIVITION_SUBDIVISION_STATS_H_
+
+#include <cstdint>
+
+namespace CatmullClarkSubdivision
+{
+    // wall time of each refinement stage in seconds, summed over every mesh and level it was collected for
+    struct SubdivisionStats
+    {
+        double TopologySeconds = 0.0; // connectivity of the parent, welding included
+        double DedupeSeconds   = 0.0; // which parent face makes each shared child vertex, and their numbering
+        double RefineSeconds   = 0.0; // stencils and child faces
+        double EvaluateSeconds = 0.0; // stencils applied to the parent vertices
+
+        uint64_t FacesCount    = 0; // made over every level
+        uint64_t VerticesCount = 0; // of the last level
+
+        double getTotalSeconds() const { return TopologySeconds + DedupeSeconds + RefineSeconds + EvaluateSeconds; }
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_SUBDIVISION_STATS_H_
@@ -0,0 +1,283 @@
+#include "synthetic_meshes.h"
+
+#include <cmath>
+#include <unordered_map>
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    const float PI = 3.14159265358979f;
+
+    // one point per edge, shared by both faces along it
+    class MidpointCache
+    {
+    public:
+        explicit MidpointCache(std::vector<glm::vec3>& positions) : m_positions(positions) { }
+
+        uint32_t get(uint32_t a, uint32_t b)
+        {
+            uint64_t key = a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+
+            auto found = m_midpoints.find(key);
+            if (found != m_midpoints.end())
+                return found->second;
+
+            uint32_t midpoint = static_cast<uint32_t>(m_positions.size());
+            m_positions.push_back(0.5f * (m_positions[a] + m_positions[b]));
+            m_midpoints.emplace(key, midpoint);
+            return midpoint;
+        }
+
+    private:
+        std::vector<glm::vec3>& m_positions;
+        std::unordered_map<uint64_t, uint32_t> m_midpoints;
+    };
+
+    uint32_t getGridSize(uint32_t cellsCount)
+    {
+        uint32_t size = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(cellsCount))));
+        return size > 0 ? size : 1;
+    }
+
+    // texture coordinates are spherical, there is no seam so the last column wraps back to the first
+    std::vector<Vertex> makeSphereVertices(const std::vector<glm::vec3>& positions)
+    {
+        std::vector<Vertex> vertices;
+        vertices.reserve(positions.size());
+
+        for (const glm::vec3& position : positions)
+        {
+            glm::vec3 point = glm::normalize(position);
+            glm::vec2 texCoord(std::atan2(point.z, point.x) / (2.0f * PI) + 0.5f, std::asin(point.y) / PI + 0.5f);
+            vertices.emplace_back(point, texCoord);
+        }
+
+        return vertices;
+    }
+
+    // every edge of the icosahedron cut into frequency segments, the points between its ends are shared by both faces
+    // along it and numbered from the lower end
+    class EdgePoints
+    {
+    public:
+        EdgePoints(std::vector<glm::vec3>& positions, uint32_t frequency) : m_positions(positions), m_frequency(frequency) { }
+
+        // point step of frequency from a towards b, 0 < step < frequency
+        uint32_t get(uint32_t a, uint32_t b, uint32_t step)
+        {
+            if (a > b)
+                return get(b, a, m_frequency - step);
+
+            uint64_t key = (static_cast<uint64_t>(a) << 32) | b;
+
+            auto found = m_firstPoints.find(key);
+            if (found == m_firstPoints.end())
+            {
+                uint32_t first = static_cast<uint32_t>(m_positions.size());
+
+                for (uint32_t i = 1; i < m_frequency; ++i)
+                    m_positions.push_back(glm::mix(m_positions[a], m_positions[b], static_cast<float>(i) / m_frequency));
+
+                found = m_firstPoints.emplace(key, first).first;
+            }
+
+            return found->second + step - 1;
+        }
+
+    private:
+        std::vector<glm::vec3>& m_positions;
+        uint32_t m_frequency;
+        std::unordered_map<uint64_t, uint32_t> m_firstPoints;
+    };
+
+    // every icosahedron face split into a triangular grid of frequency^2 triangles, the smallest frequency giving
+    // facesCount, so the count is 20 * frequency^2 and stays close to it instead of growing by four each split
+    void makeIcosphere(uint32_t facesCount, std::vector<glm::vec3>& positions, std::vector<glm::uvec3>& triangles)
+    {
+        const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+
+        positions = { { -1.0f,  t,  0.0f }, {  1.0f,  t,  0.0f }, { -1.0f, -t,  0.0f }, {  1.0f, -t,  0.0f },
+                      {  0.0f, -1.0f,  t }, {  0.0f,  1.0f,  t }, {  0.0f, -1.0f, -t }, {  0.0f,  1.0f, -t },
+                      {  t,  0.0f, -1.0f }, {  t,  0.0f,  1.0f }, { -t,  0.0f, -1.0f }, { -t,  0.0f,  1.0f } };
+
+        const std::vector<glm::uvec3> icosahedron = {
+            { 0, 11, 5 }, { 0, 5, 1 },  { 0, 1, 7 },   { 0, 7, 10 }, { 0, 10, 11 },
+            { 1, 5, 9 },  { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+            { 3, 9, 4 },  { 3, 4, 2 },  { 3, 2, 6 },   { 3, 6, 8 },  { 3, 8, 9 },
+            { 4, 9, 5 },  { 2, 4, 11 }, { 6, 2, 10 },  { 8, 6, 7 },  { 9, 8, 1 } };
+
+        uint32_t frequency = getGridSize((facesCount + 19) / 20);
+
+        EdgePoints edgePoints(positions, frequency);
+
+        triangles.clear();
+        triangles.reserve(icosahedron.size() * frequency * frequency);
+
+        std::vector<uint32_t> points;
+
+        for (const glm::uvec3& face : icosahedron)
+        {
+            // row j from the edge x-y (j = 0) to the corner z, column i from the edge x-z (i = 0)
+            points.clear();
+
+            for (uint32_t j = 0; j <= frequency; ++j)
+            {
+                for (uint32_t i = 0; i + j <= frequency; ++i)
+                {
+                    if (j == frequency)
+                        points.push_back(face.z);
+                    else if (i == 0)
+                        points.push_back(j == 0 ? face.x : edgePoints.get(face.x, face.z, j));
+                    else if (i + j == frequency)
+                        points.push_back(j == 0 ? face.y : edgePoints.get(face.y, face.z, j));
+                    else if (j == 0)
+                        points.push_back(edgePoints.get(face.x, face.y, i));
+                    else
+                    {
+                        points.push_back(static_cast<uint32_t>(positions.size()));
+                        positions.push_back(positions[face.x] + (static_cast<float>(i) / frequency) * (positions[face.y] - positions[face.x]) +
+                                            (static_cast<float>(j) / frequency) * (positions[face.z] - positions[face.x]));
+                    }
+                }
+            }
+
+            uint32_t row = 0; // first point of row j
+            for (uint32_t j = 0; j < frequency; ++j)
+            {
+                uint32_t rowSize = frequency + 1 - j;
+                uint32_t next = row + rowSize;
+
+                for (uint32_t i = 0; i + j < frequency; ++i)
+                {
+                    triangles.emplace_back(points[row + i], points[row + i + 1], points[next + i]);
+
+                    if (i + j + 1 < frequency)
+                        triangles.emplace_back(points[row + i + 1], points[next + i + 1], points[next + i]);
+                }
+
+                row = next;
+            }
+        }
+
+        for (glm::vec3& position : positions)
+            position = glm::normalize(position);
+    }
+}
+
+void CatmullClarkSubdivision::makeSyntheticMeshes(uint32_t facesCount, std::vector<SyntheticMesh<glm::uvec4>>& meshes)
+{
+    meshes.clear();
+
+    {
+        SyntheticMesh<glm::uvec4> grid;
+        grid.Name = "grid";
+
+        uint32_t size = getGridSize(facesCount);
+
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x)
+            {
+                glm::vec2 texCoord(static_cast<float>(x) / size, static_cast<float>(y) / size);
+                grid.Vertices.emplace_back(glm::vec3(texCoord.x - 0.5f, 0.0f, texCoord.y - 0.5f), texCoord);
+            }
+        }
+
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                uint32_t corner = y * (size + 1) + x;
+                grid.Faces.emplace_back(corner, corner + size + 1, corner + size + 2, corner + 1);
+            }
+        }
+
+        meshes.emplace_back(std::move(grid));
+    }
+
+    {
+        SyntheticMesh<glm::uvec4> sphere;
+        sphere.Name = "split_icosphere";
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::uvec3> triangles;
+        makeIcosphere((facesCount + 2) / 3, positions, triangles);
+
+        MidpointCache midpoints(positions);
+
+        for (const glm::uvec3& triangle : triangles)
+        {
+            uint32_t centre = static_cast<uint32_t>(positions.size());
+            positions.push_back((positions[triangle.x] + positions[triangle.y] + positions[triangle.z]) / 3.0f);
+
+            uint32_t ab = midpoints.get(triangle.x, triangle.y);
+            uint32_t bc = midpoints.get(triangle.y, triangle.z);
+            uint32_t ca = midpoints.get(triangle.z, triangle.x);
+
+            sphere.Faces.emplace_back(triangle.x, ab, centre, ca);
+            sphere.Faces.emplace_back(triangle.y, bc, centre, ab);
+            sphere.Faces.emplace_back(triangle.z, ca, centre, bc);
+        }
+
+        sphere.Vertices = makeSphereVertices(positions);
+        meshes.emplace_back(std::move(sphere));
+    }
+}
+
+void CatmullClarkSubdivision::makeSyntheticMeshes(uint32_t facesCount, std::vector<SyntheticMesh<glm::uvec3>>& meshes)
+{
+    meshes.clear();
+
+    {
+        SyntheticMesh<glm::uvec3> sphere;
+        sphere.Name = "icosphere";
+
+        std::vector<glm::vec3> positions;
+        makeIcosphere(facesCount, positions, sphere.Faces);
+
+        sphere.Vertices = makeSphereVertices(positions);
+        meshes.emplace_back(std::move(sphere));
+    }
+
+    {
+        SyntheticMesh<glm::uvec3> grid;
+        grid.Name = "star_grid";
+
+        uint32_t size = getGridSize((facesCount + 3) / 4);
+        uint32_t cornersCount = (size + 1) * (size + 1);
+
+        for (uint32_t y = 0; y <= size; ++y)
+        {
+            for (uint32_t x = 0; x <= size; ++x)
+            {
+                glm::vec2 texCoord(static_cast<float>(x) / size, static_cast<float>(y) / size);
+                grid.Vertices.emplace_back(glm::vec3(texCoord.x - 0.5f, 0.0f, texCoord.y - 0.5f), texCoord);
+            }
+        }
+
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                glm::vec2 texCoord((x + 0.5f) / size, (y + 0.5f) / size);
+                grid.Vertices.emplace_back(glm::vec3(texCoord.x - 0.5f, 0.0f, texCoord.y - 0.5f), texCoord);
+
+                uint32_t centre = cornersCount + y * size + x;
+                uint32_t corner = y * (size + 1) + x;
+
+                uint32_t a = corner;
+                uint32_t b = corner + size + 1;
+                uint32_t c = corner + size + 2;
+                uint32_t d = corner + 1;
+
+                grid.Faces.emplace_back(a, b, centre);
+                grid.Faces.emplace_back(b, c, centre);
+                grid.Faces.emplace_back(c, d, centre);
+                grid.Faces.emplace_back(d, a, centre);
+            }
+        }
+
+        meshes.emplace_back(std::move(grid));
+    }
+}
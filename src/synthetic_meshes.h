@@ -0,0 +1,35 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_SYNTHETIC_MESHES_H_
+#define CATMULL_CLARK_SUBDIVITION_SYNTHETIC_MESHES_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vertex.h"
+
+namespace CatmullClarkSubdivision
+{
+    // Generated inputs for microbenchmarks, the same for a given faces count on every run and machine
+    template <typename Face>
+    struct SyntheticMesh
+    {
+        std::string         Name;
+        std::vector<Vertex> Vertices;
+        std::vector<Face>   Faces;
+    };
+
+    // at least facesCount faces each, only a few percent more for any but tiny counts:
+    //     "grid", a square of quads where every inner vertex is regular
+    //     "split_icosphere", icosphere triangles split into three quads around their centre, every centre has
+    //     valence three and every original vertex five or six
+    void makeSyntheticMeshes(uint32_t facesCount, std::vector<SyntheticMesh<glm::uvec4>>& meshes);
+
+    //     "icosphere", an icosahedron with every face split into a triangular grid, all but twelve vertices are regular
+    //     "star_grid", grid squares fanned into four triangles, no inner vertex has valence six
+    void makeSyntheticMeshes(uint32_t facesCount, std::vector<SyntheticMesh<glm::uvec3>>& meshes);
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_SYNTHETIC_MESHES_H_
@@ -0,0 +1,273 @@
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "thread_pool.h"
+
+using namespace CatmullClarkSubdivision;
+
+const size_t TextureCache::MAX_UPLOADS_COUNT;
+
+namespace
+{
+    // FNV-1a of the whole file, the size goes into the key as well
+    std::string getContentKey(const std::string& content)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char byte : content)
+        {
+            hash ^= static_cast<unsigned char>(byte);
+            hash *= 1099511628211ull;
+        }
+
+        char buffer[40] = { 0 };
+        std::snprintf(buffer, sizeof(buffer), "%016llx-%llu", static_cast<unsigned long long>(hash), static_cast<unsigned long long>(content.size()));
+        return buffer;
+    }
+}
+
+TextureCache& TextureCache::getInstance()
+{
+    static TextureCache instance;
+    return instance;
+}
+
+std::string TextureCache::acquire(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::string key = getContentKey(content);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto found = m_entries.find(key);
+        if (found != m_entries.end())
+        {
+            ++found->second.ReferencesCount;
+            return key;
+        }
+    }
+
+    // decoding happens unlocked, if another thread got the same content in meanwhile its image is kept
+    Image image = decodeImage(path, content);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Entry& entry = m_entries[key];
+    if (entry.ReferencesCount == 0)
+        entry.Pixels = image;
+
+    ++entry.ReferencesCount;
+    return key;
+}
+
+unsigned TextureCache::getTexture(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto found = m_entries.find(key);
+    if (found == m_entries.end())
+        return 0;
+
+    Entry& entry = found->second;
+    if (!entry.Id)
+    {
+        entry.Id = createPlaceholder();
+
+        // a file that failed to decode keeps the placeholder
+        if (entry.Pixels.Pixels)
+            m_waiting.push_back(key);
+    }
+
+    return entry.Id;
+}
+
+void TextureCache::update()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto key = m_uploading.begin(); key != m_uploading.end();)
+    {
+        Entry& entry = m_entries[*key];
+        Upload& upload = entry.Pending;
+
+        if (!upload.Fence)
+        {
+            if (upload.Copy.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                finishUpload(entry);
+
+            ++key;
+            continue;
+        }
+
+        GLenum status = glClientWaitSync(upload.Fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+        {
+            freeUpload(entry);
+            key = m_uploading.erase(key);
+        }
+        else
+        {
+            ++key;
+        }
+    }
+
+    while (m_uploading.size() < MAX_UPLOADS_COUNT && !m_waiting.empty())
+    {
+        startUpload(m_entries[m_waiting.front()]);
+        m_uploading.push_back(m_waiting.front());
+        m_waiting.pop_front();
+    }
+}
+
+bool TextureCache::isUploading()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_waiting.empty() || !m_uploading.empty();
+}
+
+void TextureCache::release(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto found = m_entries.find(key);
+    if (found == m_entries.end() || --found->second.ReferencesCount > 0)
+        return;
+
+    if (found->second.Pending.Buffer)
+    {
+        freeUpload(found->second);
+        m_uploading.erase(std::find(m_uploading.begin(), m_uploading.end(), key));
+    }
+    else
+    {
+        m_waiting.erase(std::remove(m_waiting.begin(), m_waiting.end(), key), m_waiting.end());
+    }
+
+    if (found->second.Id)
+        glDeleteTextures(1, &found->second.Id);
+
+    m_entries.erase(found);
+}
+
+Image TextureCache::decodeImage(const std::string& path, const std::string& content)
+{
+    // the flag is per thread, importers run on several
+    stbi_set_flip_vertically_on_load_thread(false);
+
+    Image image;
+    unsigned char* data = nullptr;
+
+    if (!content.empty())
+        data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(content.data()), static_cast<int>(content.size()),
+                                     &image.Width, &image.Height, &image.Components, 0);
+
+    if (data)
+        image.Pixels.reset(data, stbi_image_free);
+    else
+        std::cerr << "Texture failed to load at path: " << path << std::endl;
+
+    return image;
+}
+
+unsigned TextureCache::createPlaceholder()
+{
+    const unsigned char grey[4] = { 128, 128, 128, 255 };
+
+    unsigned textureID;
+    glGenTextures(1, &textureID);
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+
+    // no mipmaps until the real pixels arrive, a mipmapped filter would leave the texture incomplete
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return textureID;
+}
+
+void TextureCache::startUpload(Entry& entry)
+{
+    Upload& upload = entry.Pending;
+
+    size_t size = static_cast<size_t>(entry.Pixels.Width) * entry.Pixels.Height * entry.Pixels.Components;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &upload.Buffer);
+    glNamedBufferStorage(upload.Buffer, static_cast<GLsizeiptr>(size), nullptr, flags);
+    upload.Mapped = glMapNamedBufferRange(upload.Buffer, 0, static_cast<GLsizeiptr>(size), flags);
+
+    // the copy keeps its own reference, the entry may drop the pixels before it runs
+    std::shared_ptr<unsigned char> pixels = entry.Pixels.Pixels;
+    void* mapped = upload.Mapped;
+
+    upload.Copy = ThreadPool::getInstance().submit([pixels, mapped, size]()
+    {
+        std::memcpy(mapped, pixels.get(), size);
+    });
+}
+
+void TextureCache::finishUpload(Entry& entry)
+{
+    Upload& upload = entry.Pending;
+    upload.Copy.get();
+
+    const Image& image = entry.Pixels;
+
+    GLenum format = GL_RGB;
+    if (image.Components == 1)
+        format = GL_RED;
+    else if (image.Components == 3)
+        format = GL_RGB;
+    else if (image.Components == 4)
+        format = GL_RGBA;
+
+    // the pixels come from the buffer, the GPU copies them without stalling this thread.
+    // Rows are tightly packed, whatever the width
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.Buffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    glBindTexture(GL_TEXTURE_2D, entry.Id);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.Width, image.Height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    upload.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    entry.Pixels = Image();
+}
+
+void TextureCache::freeUpload(Entry& entry)
+{
+    Upload& upload = entry.Pending;
+
+    // the copy writes into the mapping, it has to be done before the buffer goes
+    if (upload.Copy.valid())
+        upload.Copy.wait();
+
+    if (upload.Fence)
+        glDeleteSync(upload.Fence);
+
+    glUnmapNamedBuffer(upload.Buffer);
+    glDeleteBuffers(1, &upload.Buffer);
+
+    entry.Pending = Upload();
+}
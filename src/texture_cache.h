@@ -0,0 +1,91 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_TEXTURE_CACHE_H_
+#define CATMULL_CLARK_SUBDIVITION_TEXTURE_CACHE_H_
+
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#undef APIENTRY
+#include <glad/glad.h>
+
+namespace CatmullClarkSubdivision
+{
+    // decoded pixels waiting for their GL texture
+    struct Image
+    {
+        int Width      = 0;
+        int Height     = 0;
+        int Components = 0;
+        std::shared_ptr<unsigned char> Pixels;
+    };
+
+    // Engine-wide textures addressed by file content, so every model and every path holding the same bytes
+    // shares one decoded image and one GL texture. Entries are reference counted and freed with their last user.
+    // Pixels reach the GPU in the background: a texture starts as a 1x1 grey placeholder under its final id,
+    // update copies the pixels into a mapped pixel buffer on the pool and respecifies the texture from it.
+    // acquire may be called from any thread, everything else only on the thread owning the GL context
+    class TextureCache
+    {
+    public:
+        TextureCache(const TextureCache& other)            = delete;
+        TextureCache(TextureCache&& other)                 = delete;
+        TextureCache& operator=(const TextureCache& other) = delete;
+        TextureCache& operator=(TextureCache&& other)      = delete;
+
+        static TextureCache& getInstance();
+
+        // reads and hashes the file, decodes it only if that content isn't cached yet, and takes a reference.
+        // Returns the key of the content, a missing file yields an empty texture like before
+        std::string acquire(const std::string& path);
+
+        // GL texture for the key, a placeholder until its upload completes in update
+        unsigned getTexture(const std::string& key);
+
+        // advances the uploads without blocking, called once per frame
+        void update();
+        bool isUploading();
+
+        // drops one reference, the texture is deleted with the last one
+        void release(const std::string& key);
+
+    private:
+        TextureCache() { }
+
+        // pixels on their way to the texture through a persistently mapped buffer
+        struct Upload
+        {
+            unsigned Buffer = 0;
+            void* Mapped = nullptr;
+            std::future<void> Copy; // pixels into Mapped, on the pool
+            GLsync Fence = nullptr; // set once the texture is specified from Buffer, the buffer lives until it signals
+        };
+
+        struct Entry
+        {
+            Image Pixels;
+            unsigned Id = 0;
+            unsigned ReferencesCount = 0;
+            Upload Pending;
+        };
+
+        static Image decodeImage(const std::string& path, const std::string& content);
+        static unsigned createPlaceholder();
+
+        void startUpload(Entry& entry);
+        void finishUpload(Entry& entry);
+        void freeUpload(Entry& entry);
+
+        static const size_t MAX_UPLOADS_COUNT = 4; // buffers alive at once, each as big as its image
+
+        std::mutex m_mutex;
+        std::map<std::string, Entry> m_entries; // content hash and size -> texture
+        std::deque<std::string> m_waiting;      // keys with a placeholder, not uploading yet
+        std::deque<std::string> m_uploading;    // keys with an Upload in flight
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_TEXTURE_CACHE_H_
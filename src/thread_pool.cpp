@@ -0,0 +1,166 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+using namespace CatmullClarkSubdivision;
+
+ThreadPool::ThreadPool(unsigned threadsCount)
+{
+    start(threadsCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+    stop();
+}
+
+ThreadPool& ThreadPool::getInstance()
+{
+    static ThreadPool instance;
+    return instance;
+}
+
+void ThreadPool::resize(unsigned threadsCount)
+{
+    stop();
+    start(threadsCount);
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    if (m_workers.empty())
+    {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.emplace_back(std::move(task));
+    }
+
+    m_condition.notify_one();
+}
+
+void ThreadPool::parallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t begin, uint32_t end)>& body)
+{
+    grain = std::max(grain, 1u);
+    const uint32_t chunksCount = count / grain + (count % grain ? 1 : 0);
+
+    if (chunksCount == 0)
+        return;
+
+    if (chunksCount == 1 || m_workers.empty())
+    {
+        for (uint32_t begin = 0; begin < count; begin += std::min(grain, count - begin))
+            body(begin, begin + std::min(grain, count - begin));
+        return;
+    }
+
+    // helpers may be picked up after everything is done, so the shared state outlives this call
+    struct State
+    {
+        std::atomic<uint32_t> Next { 0 };
+        std::atomic<uint32_t> Done { 0 };
+        std::mutex Mutex;
+        std::condition_variable Finished;
+        std::exception_ptr Error;
+    };
+
+    std::shared_ptr<State> state = std::make_shared<State>();
+
+    // body is only touched after taking a chunk, which can't happen once parallelFor has returned
+    const std::function<void(uint32_t, uint32_t)>* task = &body;
+
+    auto work = [state, task, count, grain, chunksCount]()
+    {
+        for (;;)
+        {
+            uint32_t chunk = state->Next.fetch_add(1);
+            if (chunk >= chunksCount)
+                return;
+
+            uint32_t begin = chunk * grain;
+
+            try
+            {
+                (*task)(begin, begin + std::min(grain, count - begin));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->Mutex);
+                if (!state->Error)
+                    state->Error = std::current_exception();
+            }
+
+            if (state->Done.fetch_add(1) + 1 == chunksCount)
+            {
+                std::lock_guard<std::mutex> lock(state->Mutex);
+                state->Finished.notify_all();
+            }
+        }
+    };
+
+    unsigned helpersCount = std::min(static_cast<unsigned>(m_workers.size()), chunksCount - 1);
+    for (unsigned i = 0; i < helpersCount; ++i)
+        enqueue(work);
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->Mutex);
+    state->Finished.wait(lock, [&state, chunksCount]() { return state->Done.load() == chunksCount; });
+
+    if (state->Error)
+        std::rethrow_exception(state->Error);
+}
+
+void ThreadPool::start(unsigned threadsCount)
+{
+    if (threadsCount == 0)
+        threadsCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    m_stopping = false;
+    m_workers.reserve(threadsCount - 1);
+
+    for (unsigned i = 1; i < threadsCount; ++i)
+        m_workers.emplace_back(&ThreadPool::run, this);
+}
+
+void ThreadPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_condition.notify_all();
+
+    for (std::thread& worker : m_workers)
+        worker.join();
+
+    m_workers.clear();
+}
+
+void ThreadPool::run()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+            // queued tasks are still run when stopping, someone may be waiting on them
+            if (m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_THREAD_POOL_H_
+#define CATMULL_CLARK_SUBDIVITION_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace CatmullClarkSubdivision
+{
+    // Fixed set of worker threads fed from one task queue.
+    // parallelFor lets the calling thread take chunks too, so it can be nested inside a task without deadlocking.
+    class ThreadPool
+    {
+    public:
+        // zero picks one thread per hardware thread, the calling thread counts as one of them
+        explicit ThreadPool(unsigned threadsCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool& other)            = delete;
+        ThreadPool(ThreadPool&& other)                 = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+        ThreadPool& operator=(ThreadPool&& other)      = delete;
+
+        // pool shared by refinement and stencil evaluation
+        static ThreadPool& getInstance();
+
+        // most threads a command line may ask for, far above any machine this runs on
+        static const unsigned MAX_THREADS_COUNT = 1024;
+
+        // finishes the queued tasks and restarts with another number of threads, must not race with other calls
+        void resize(unsigned threadsCount);
+
+        unsigned getThreadsCount() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+
+        // runs the task on a worker, or right away when there are none
+        void enqueue(std::function<void()> task);
+
+        // enqueues the task, the future holds its result or the exception it threw
+        template <typename Task>
+        std::future<typename std::result_of<Task()>::type> submit(Task task)
+        {
+            typedef typename std::result_of<Task()>::type Result;
+
+            // std::function needs a copyable target, the packaged task is shared instead
+            std::shared_ptr<std::packaged_task<Result()>> packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+            std::future<Result> result = packaged->get_future();
+
+            enqueue([packaged]() { (*packaged)(); });
+
+            return result;
+        }
+
+        // runs body(begin, end) over [0, count) split into grain sized chunks, chunk i starts at i * grain.
+        // Returns when every chunk is done and rethrows the first exception thrown by body
+        void parallelFor(uint32_t count, uint32_t grain, const std::function<void(uint32_t begin, uint32_t end)>& body);
+
+    private:
+        void start(unsigned threadsCount);
+        void stop();
+        void run();
+
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_stopping = false;
+    };
+
+    // lowers value to candidate if it is smaller, the result doesn't depend on the order threads get here
+    inline void atomicMin(std::atomic<uint32_t>& value, uint32_t candidate)
+    {
+        uint32_t current = value.load(std::memory_order_relaxed);
+        while (candidate < current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) { }
+    }
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_THREAD_POOL_H_
@@ -2,31 +2,72 @@
 #ifndef CATMULL_CLARK_SUBDIVITION_UTILS_H_
 #define CATMULL_CLARK_SUBDIVITION_UTILS_H_
 
-#include <exception>
-#include <fstream>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace CatmullClarkSubdivision
 {
+#ifdef _WIN32
+
     static std::string getFileFullPath(const char* name)
     {
         char moduleName[_MAX_PATH] = { 0 };
         if (!GetModuleFileNameA(nullptr, moduleName, _MAX_PATH))
-            throw std::exception(std::error_code(static_cast<int>(GetLastError()), std::system_category()).message().c_str());
+            throw std::runtime_error(std::error_code(static_cast<int>(GetLastError()), std::system_category()).message());
 
         char drive[_MAX_DRIVE] = { 0 };
         char path[_MAX_PATH] = { 0 };
 
         if (_splitpath_s(moduleName, drive, _MAX_DRIVE, path, _MAX_PATH, nullptr, 0, nullptr, 0))
-            throw std::exception("Can't split path");
+            throw std::runtime_error("Can't split path");
 
         char filename[_MAX_PATH];
         if (_makepath_s(filename, _MAX_PATH, drive, path, name, nullptr))
-            throw std::exception("Can't find filename");
+            throw std::runtime_error("Can't find filename");
 
         return filename;
     }
+
+    // false when it couldn't be made, a directory that already exists is fine
+    static bool createDirectory(const std::string& path)
+    {
+        return CreateDirectoryA(path.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+    }
+
+#else
+
+    // next to the executable as well, found through procfs
+    static std::string getFileFullPath(const char* name)
+    {
+        char moduleName[PATH_MAX] = { 0 };
+        ssize_t length = readlink("/proc/self/exe", moduleName, PATH_MAX - 1);
+        if (length < 0)
+            throw std::runtime_error(std::error_code(errno, std::system_category()).message());
+
+        std::string path(moduleName, static_cast<size_t>(length));
+        size_t separator = path.find_last_of('/');
+        if (separator == std::string::npos)
+            throw std::runtime_error("Can't split path");
+
+        return path.substr(0, separator + 1).append(name);
+    }
+
+    static bool createDirectory(const std::string& path)
+    {
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+    }
+
+#endif
 }
 
 #endif // CATMULL_CLARK_SUBDIVITION_UTILS_H_
@@ -0,0 +1,19 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_VERTEX_H_
+#define CATMULL_CLARK_SUBDIVITION_VERTEX_H_
+
+#include <glm/glm.hpp>
+
+namespace CatmullClarkSubdivision
+{
+    struct Vertex
+    {
+        Vertex() : Position{ glm::vec3(0.0f) }, TexCoord{ glm::vec2(0.0f) } { }
+        Vertex(const glm::vec3& position, const glm::vec2& texCoord) : Position{ position }, TexCoord{ texCoord } { }
+
+        glm::vec3 Position;
+        glm::vec2 TexCoord;
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_VERTEX_H_
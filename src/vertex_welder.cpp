@@ -0,0 +1,105 @@
+#include "vertex_welder.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace CatmullClarkSubdivision;
+
+namespace
+{
+    uint32_t floatBits(float value)
+    {
+        // fold -0.0f into 0.0f so both weld together
+        value += 0.0f;
+
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}
+
+const uint32_t VertexWelder::INVALID_INDEX;
+
+size_t VertexWelder::CellKeyHash::operator()(const CellKey& key) const
+{
+    uint64_t hash = key.X * 0x9E3779B97F4A7C15ull;
+    hash ^= key.Y + 0x7F4A7C159E3779B9ull + (hash << 6) + (hash >> 2);
+    hash ^= key.Z + 0x94D049BB133111EBull + (hash << 6) + (hash >> 2);
+    return static_cast<size_t>(hash);
+}
+
+VertexWelder::VertexWelder(float tolerance)
+    : m_tolerance { tolerance > 0.0f ? tolerance : 0.0f },
+      m_cellScale { tolerance > 0.0f ? 1.0f / tolerance : 0.0f }
+{
+}
+
+void VertexWelder::reserve(size_t count)
+{
+    m_cells.reserve(count);
+    m_nextInCell.reserve(count);
+    m_positions.reserve(count);
+}
+
+uint32_t VertexWelder::weld(const glm::vec3& position)
+{
+    CellKey key = cellOf(position);
+    uint32_t point = INVALID_INDEX;
+
+    if (m_tolerance == 0.0f)
+    {
+        // exact keys: every point in a cell has the same position
+        auto it = m_cells.find(key);
+        if (it != m_cells.end())
+            return it->second;
+    }
+    else
+    {
+        for (uint32_t dz = 0; dz < 3 && point == INVALID_INDEX; ++dz)
+            for (uint32_t dy = 0; dy < 3 && point == INVALID_INDEX; ++dy)
+                for (uint32_t dx = 0; dx < 3 && point == INVALID_INDEX; ++dx)
+                    point = find(CellKey { key.X + dx - 1, key.Y + dy - 1, key.Z + dz - 1 }, position);
+
+        if (point != INVALID_INDEX)
+            return point;
+    }
+
+    point = static_cast<uint32_t>(m_positions.size());
+    m_positions.push_back(position);
+
+    auto inserted = m_cells.emplace(key, point);
+    m_nextInCell.push_back(inserted.second ? INVALID_INDEX : inserted.first->second);
+    inserted.first->second = point;
+
+    return point;
+}
+
+VertexWelder::CellKey VertexWelder::cellOf(const glm::vec3& position) const
+{
+    if (m_tolerance == 0.0f)
+        return CellKey { floatBits(position.x), floatBits(position.y), floatBits(position.z) };
+
+    glm::vec3 cell = glm::floor(position * m_cellScale);
+
+    return CellKey { static_cast<uint32_t>(static_cast<int32_t>(cell.x)),
+                     static_cast<uint32_t>(static_cast<int32_t>(cell.y)),
+                     static_cast<uint32_t>(static_cast<int32_t>(cell.z)) };
+}
+
+uint32_t VertexWelder::find(const CellKey& key, const glm::vec3& position) const
+{
+    auto it = m_cells.find(key);
+    if (it == m_cells.end())
+        return INVALID_INDEX;
+
+    const float toleranceSquared = m_tolerance * m_tolerance;
+
+    for (uint32_t point = it->second; point != INVALID_INDEX; point = m_nextInCell[point])
+    {
+        glm::vec3 delta = m_positions[point] - position;
+        if (glm::dot(delta, delta) <= toleranceSquared)
+            return point;
+    }
+
+    return INVALID_INDEX;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef CATMULL_CLARK_SUBDIVITION_VERTEX_WELDER_H_
+#define CATMULL_CLARK_SUBDIVITION_VERTEX_WELDER_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace CatmullClarkSubdivision
+{
+    // Spatial hash that maps positions to point ids in O(1).
+    // With zero tolerance positions are keyed by their exact bit pattern, otherwise they are quantized
+    // into a grid of tolerance-sized cells and the neighbouring cells are searched for a close enough point.
+    class VertexWelder
+    {
+    public:
+        explicit VertexWelder(float tolerance = 0.0f);
+
+        void reserve(size_t count);
+
+        // returns the id of a point within tolerance of the position, adding a new point if there is none
+        uint32_t weld(const glm::vec3& position);
+
+        uint32_t getPointsCount() const { return static_cast<uint32_t>(m_positions.size()); }
+
+    private:
+        static const uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+        struct CellKey
+        {
+            uint32_t X;
+            uint32_t Y;
+            uint32_t Z;
+
+            bool operator==(const CellKey& other) const { return X == other.X && Y == other.Y && Z == other.Z; }
+        };
+
+        struct CellKeyHash
+        {
+            size_t operator()(const CellKey& key) const;
+        };
+
+        CellKey cellOf(const glm::vec3& position) const;
+        uint32_t find(const CellKey& key, const glm::vec3& position) const;
+
+        float m_tolerance = 0.0f;
+        float m_cellScale = 0.0f;
+
+        std::unordered_map<CellKey, uint32_t, CellKeyHash> m_cells; // cell -> last point added to it
+        std::vector<uint32_t>  m_nextInCell;                        // point -> previous point of the same cell
+        std::vector<glm::vec3> m_positions;
+    };
+}
+
+#endif // CATMULL_CLARK_SUBDIVITION_VERTEX_WELDER_H_